@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file AlexandriaKernel/CancellationToken.h
+ * @author nikoapos
+ */
+
+#ifndef _ALEXANDRIAKERNEL_CANCELLATIONTOKEN_H
+#define _ALEXANDRIAKERNEL_CANCELLATIONTOKEN_H
+
+#include <atomic>
+#include <memory>
+
+namespace Euclid {
+
+/**
+ * @class CancellationToken
+ *
+ * @brief Flag used to cooperatively cancel long running tasks
+ *
+ * @details
+ * Copies of a token share the same state, so a token can be captured by the
+ * tasks and cancelled from any other thread. Tasks are expected to poll
+ * isCancelled() and return early when it is true.
+ */
+class CancellationToken {
+
+public:
+
+  /// Creates a new, not cancelled, token
+  CancellationToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {
+  }
+
+  /// Requests the cancellation to all the holders of this token
+  void cancel() {
+    m_cancelled->store(true, std::memory_order_relaxed);
+  }
+
+  /// @return true if the cancellation has been requested
+  bool isCancelled() const {
+    return m_cancelled->load(std::memory_order_relaxed);
+  }
+
+private:
+
+  std::shared_ptr<std::atomic<bool>> m_cancelled;
+
+}; /* End of CancellationToken class */
+
+} /* namespace Euclid */
+
+#endif /* _ALEXANDRIAKERNEL_CANCELLATIONTOKEN_H */
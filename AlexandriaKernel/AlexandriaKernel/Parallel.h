@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file AlexandriaKernel/Parallel.h
+ * @author nikoapos
+ */
+
+#ifndef _ALEXANDRIAKERNEL_PARALLEL_H
+#define _ALEXANDRIAKERNEL_PARALLEL_H
+
+#include <cstddef>
+#include "AlexandriaKernel/ThreadPool.h"
+
+namespace Euclid {
+
+/*
+ * All the functions can be called from tasks running in the same pool: the
+ * calling worker executes queued chunks while waiting for the rest. The
+ * overloads without a pool use ThreadPool::defaultPool().
+ */
+
+/**
+ * Computes the number of consecutive indexes processed by a single task when
+ * the caller does not specify it. The range is split in a few chunks per
+ * thread, so an uneven cost per index is still balanced between the workers.
+ * @param pool
+ *  The pool that will execute the chunks
+ * @param n
+ *  Number of indexes to process
+ * @return
+ *  The grain size, which is never 0
+ */
+inline std::size_t autoGrainSize(const ThreadPool& pool, std::size_t n);
+
+/**
+ * Computes the grain size for a range whose indexes process several elements
+ * each (i.e. rows of an array). Tasks get at least min_task_cost elements, so
+ * the cost of dispatching them is amortised, and small ranges are not split.
+ * @param pool
+ *  The pool that will execute the chunks
+ * @param n
+ *  Number of indexes to process
+ * @param cost
+ *  Number of elements processed per index
+ * @param min_task_cost
+ *  Minimum number of elements processed by a task
+ * @return
+ *  The grain size, which is never 0. It is n if the range is not worth splitting.
+ */
+inline std::size_t autoGrainSize(const ThreadPool& pool, std::size_t n, std::size_t cost,
+                                 std::size_t min_task_cost = 1 << 15);
+
+/**
+ * Calls fn(i) for every i in [begin, end), splitting the range in chunks of
+ * consecutive indexes that are executed in parallel by the pool.
+ * @param pool
+ *  The pool that executes the chunks
+ * @param begin
+ *  First index
+ * @param end
+ *  One past the last index
+ * @param grain
+ *  Number of consecutive indexes processed by each task. If 0, it is chosen
+ *  automatically with autoGrainSize()
+ * @param fn
+ *  Callable receiving a std::size_t. It is called within a tight loop, so it can
+ *  be inlined and vectorized by the compiler.
+ * @throws
+ *  The first exception thrown by fn. Chunks not yet started when it happens
+ *  are skipped.
+ */
+template <typename Function>
+void parallelFor(ThreadPool& pool, std::size_t begin, std::size_t end, std::size_t grain, Function&& fn);
+
+/**
+ * Same as parallelFor(pool, begin, end, 0, fn)
+ */
+template <typename Function>
+void parallelFor(ThreadPool& pool, std::size_t begin, std::size_t end, Function&& fn) {
+  parallelFor(pool, begin, end, 0, std::forward<Function>(fn));
+}
+
+/**
+ * Same as parallelFor(ThreadPool::defaultPool(), begin, end, grain, fn)
+ */
+template <typename Function>
+void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Function&& fn) {
+  parallelFor(ThreadPool::defaultPool(), begin, end, grain, std::forward<Function>(fn));
+}
+
+/**
+ * Same as parallelFor(ThreadPool::defaultPool(), begin, end, 0, fn)
+ */
+template <typename Function>
+void parallelFor(std::size_t begin, std::size_t end, Function&& fn) {
+  parallelFor(ThreadPool::defaultPool(), begin, end, 0, std::forward<Function>(fn));
+}
+
+/**
+ * Reduces map(i) for every i in [begin, end) in parallel.
+ * Each chunk is reduced sequentially starting from identity, and the partial
+ * results are then reduced sequentially in the order of the chunks, so the
+ * result does not depend on the scheduling. For floating point types, the
+ * result is reproducible as long as the grain size is the same (an explicit
+ * grain makes it also independent of the number of threads).
+ * @param pool
+ *  The pool that executes the chunks
+ * @param begin
+ *  First index
+ * @param end
+ *  One past the last index
+ * @param grain
+ *  Number of consecutive indexes processed by each task. If 0, it is chosen
+ *  automatically with autoGrainSize()
+ * @param identity
+ *  The identity value for the reduction (i.e. 0 for a sum)
+ * @param map
+ *  Callable receiving a std::size_t and returning a value convertible to T
+ * @param reduce
+ *  Associative binary operation on T
+ * @return
+ *  The reduced value
+ */
+template <typename T, typename Map, typename Reduce>
+T parallelReduce(ThreadPool& pool, std::size_t begin, std::size_t end, std::size_t grain,
+                 const T& identity, Map&& map, Reduce&& reduce);
+
+/**
+ * Same as parallelReduce(pool, begin, end, 0, identity, map, reduce)
+ */
+template <typename T, typename Map, typename Reduce>
+T parallelReduce(ThreadPool& pool, std::size_t begin, std::size_t end, const T& identity, Map&& map,
+                 Reduce&& reduce) {
+  return parallelReduce(pool, begin, end, 0, identity, std::forward<Map>(map), std::forward<Reduce>(reduce));
+}
+
+/**
+ * Same as parallelReduce(ThreadPool::defaultPool(), begin, end, grain, identity, map, reduce)
+ */
+template <typename T, typename Map, typename Reduce>
+T parallelReduce(std::size_t begin, std::size_t end, std::size_t grain, const T& identity, Map&& map,
+                 Reduce&& reduce) {
+  return parallelReduce(ThreadPool::defaultPool(), begin, end, grain, identity, std::forward<Map>(map),
+                        std::forward<Reduce>(reduce));
+}
+
+/**
+ * Same as parallelReduce(ThreadPool::defaultPool(), begin, end, 0, identity, map, reduce)
+ */
+template <typename T, typename Map, typename Reduce>
+T parallelReduce(std::size_t begin, std::size_t end, const T& identity, Map&& map, Reduce&& reduce) {
+  return parallelReduce(ThreadPool::defaultPool(), begin, end, 0, identity, std::forward<Map>(map),
+                        std::forward<Reduce>(reduce));
+}
+
+/**
+ * Parallel version of std::transform for random access iterators.
+ * @param pool
+ *  The pool that executes the chunks
+ * @param first
+ *  Beginning of the input
+ * @param last
+ *  End of the input
+ * @param out
+ *  Beginning of the output
+ * @param op
+ *  Unary operation applied to each element
+ * @param grain
+ *  Number of consecutive elements processed by each task. If 0, it is chosen
+ *  automatically with autoGrainSize()
+ * @return
+ *  Iterator to the element past the last element written
+ */
+template <typename InputIterator, typename OutputIterator, typename UnaryOperation>
+OutputIterator parallelTransform(ThreadPool& pool, InputIterator first, InputIterator last,
+                                 OutputIterator out, UnaryOperation&& op, std::size_t grain = 0);
+
+/**
+ * Same as parallelTransform(ThreadPool::defaultPool(), first, last, out, op, grain)
+ */
+template <typename InputIterator, typename OutputIterator, typename UnaryOperation>
+OutputIterator parallelTransform(InputIterator first, InputIterator last, OutputIterator out,
+                                 UnaryOperation&& op, std::size_t grain = 0) {
+  return parallelTransform(ThreadPool::defaultPool(), first, last, out, std::forward<UnaryOperation>(op), grain);
+}
+
+} /* namespace Euclid */
+
+#include "AlexandriaKernel/_impl/Parallel.icpp"
+
+#endif /* _ALEXANDRIAKERNEL_PARALLEL_H */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file AlexandriaKernel/Pipeline.h
+ * @author nikoapos
+ */
+
+#ifndef _ALEXANDRIAKERNEL_PIPELINE_H
+#define _ALEXANDRIAKERNEL_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Euclid {
+
+namespace Pipeline_Impl {
+
+/// Part of a channel not depending on the type of the items
+class ChannelBase {
+
+public:
+
+  virtual ~ChannelBase() = default;
+
+  /// Wakes up all the producers and consumers, which give up
+  virtual void abort() = 0;
+
+  /// Set when a stage reads from the channel, which can happen only once
+  bool consumed = false;
+
+};
+
+/**
+ * @brief Bounded queue connecting two stages
+ * @details
+ *  The items are numbered, in the order they are popped, so a parallel stage
+ *  can restore the order of its input on its output. The channel is closed
+ *  (end of stream) when all its producers are done.
+ */
+template <typename T>
+class Channel : public ChannelBase {
+
+public:
+
+  Channel(std::size_t capacity, unsigned producers);
+
+  /// Appends an item, waiting for space. Returns false if the pipeline is aborted.
+  bool push(T item);
+
+  /// Appends the item with the given sequence number, waiting for space and for
+  /// all the previous items. Returns false if the pipeline is aborted.
+  bool push(std::size_t seq, T item);
+
+  /// Takes the next item, waiting for it. Returns false at the end of the stream,
+  /// or if the pipeline is aborted.
+  bool pop(std::size_t& seq, T& item);
+
+  /// Called by each producer when it will not push more items
+  void producerDone();
+
+  void abort() override;
+
+private:
+
+  std::mutex m_mutex;
+  std::condition_variable m_not_full;
+  std::condition_variable m_not_empty;
+  std::deque<T> m_items;
+  std::size_t m_capacity;
+  unsigned m_producers;
+  /// Sequence number of the next pushed item
+  std::size_t m_pushed = 0;
+  /// Sequence number of the next popped item
+  std::size_t m_popped = 0;
+  bool m_aborted = false;
+
+};
+
+} // end of namespace Pipeline_Impl
+
+/**
+ * @class Pipeline
+ *
+ * @brief Runs a sequence of processing stages concurrently, connected by bounded queues
+ *
+ * @details
+ * A pipeline is built from a source, any number of intermediate stages, and
+ * sinks consuming the output of the last stages. For example, reading table
+ * chunks, converting them, and writing the results:
+ *
+ * @code
+ * Pipeline pipeline;
+ * auto chunks = pipeline.source<Table::Table>([&reader](Table::Table& chunk) {
+ *   if (!reader.hasMoreRows()) return false;
+ *   chunk = reader.read(1000);
+ *   return true;
+ * });
+ * auto results = pipeline.stage(chunks, [](Table::Table chunk) { return compute(chunk); }, 4);
+ * pipeline.sink(results, [&writer](Table::Table result) { writer.addData(result); });
+ * pipeline.run();
+ * @endcode
+ *
+ * Each stage runs in its own threads, so reading, computing and writing
+ * overlap. The number of items between two stages is bounded, so a fast
+ * stage waits for a slow one instead of filling up the memory. The stages
+ * block while waiting for their input, so they do not run in a ThreadPool
+ * (which could deadlock if there were more stage threads than workers), but
+ * a stage function can still use a pool for its own work.
+ *
+ * An intermediate stage can run in several threads. With Ordering::ORDERED
+ * its output is in the same order as its input, at the cost of a fast thread
+ * waiting for the slower ones sometimes. With Ordering::UNORDERED the items
+ * are passed on as soon as they are ready.
+ *
+ * When the source returns false, the end of the stream is propagated through
+ * all the stages, and run() returns once the sinks have processed all the
+ * items. If any stage throws, all the stages are stopped and run() rethrows
+ * the first exception. cancel() stops all the stages without an error.
+ */
+class Pipeline {
+
+public:
+
+  enum class Ordering {
+    ORDERED,   ///< The stage output keeps the order of its input
+    UNORDERED  ///< The items are passed on in the order they are finished
+  };
+
+  /// Handle to the output of a stage, to be passed to the next stage
+  template <typename T>
+  class Stage {
+  public:
+    using value_type = T;
+  private:
+    friend class Pipeline;
+    explicit Stage(std::shared_ptr<Pipeline_Impl::Channel<T>> channel) : m_channel(std::move(channel)) {
+    }
+    std::shared_ptr<Pipeline_Impl::Channel<T>> m_channel;
+  };
+
+  /**
+   * @brief Constructor
+   * @param queue_capacity
+   *    Maximum number of items waiting between two stages
+   */
+  explicit Pipeline(std::size_t queue_capacity = 16);
+
+  /// Destructor
+  virtual ~Pipeline() = default;
+
+  /**
+   * @brief Adds the stage producing the items
+   * @tparam T
+   *    The type of the items. It must be default constructible.
+   * @param generator
+   *    Called repeatedly with a reference to the next item to fill, until it
+   *    returns false
+   */
+  template <typename T, typename Generator>
+  Stage<T> source(Generator generator);
+
+  /**
+   * @brief Adds a stage transforming each item of the input
+   * @param input
+   *    The stage providing the input. Each stage can have a single consumer.
+   * @param fn
+   *    Callable receiving an item of the input and returning the output item.
+   *    The same instance is called by all the threads of the stage.
+   * @param parallelism
+   *    Number of threads calling fn
+   * @param ordering
+   *    If the output must keep the order of the input
+   * @throws Elements::Exception
+   *    If the input is already consumed, or parallelism is 0
+   */
+  template <typename In, typename Function,
+            typename Out = typename std::decay<typename std::result_of<Function(In)>::type>::type>
+  Stage<Out> stage(Stage<In> input, Function fn, unsigned parallelism = 1,
+                   Ordering ordering = Ordering::ORDERED);
+
+  /**
+   * @brief Adds the stage consuming the items of the input
+   * @details
+   *    The sink runs in a single thread and receives the items in the order of
+   *    its input.
+   * @throws Elements::Exception
+   *    If the input is already consumed
+   */
+  template <typename In, typename Function>
+  void sink(Stage<In> input, Function fn);
+
+  /**
+   * @brief Runs all the stages and waits for them to finish
+   * @throws Elements::Exception
+   *    If the pipeline already run, or the output of a stage is not consumed
+   * @throws
+   *    The first exception thrown by a stage
+   */
+  void run();
+
+  /// Stops all the stages. Can be called from any thread, including the stages.
+  void cancel();
+
+private:
+
+  /// Reports the exception of a stage and stops the rest of the stages
+  void fail(std::exception_ptr exception);
+
+  /// Marks the channel as consumed, throwing if it already is
+  void consume(Pipeline_Impl::ChannelBase& channel);
+
+  /// Runs a stage loop, reporting its exceptions
+  void runStage(const std::function<void()>& loop);
+
+  std::size_t m_queue_capacity;
+  std::vector<std::shared_ptr<Pipeline_Impl::ChannelBase>> m_channels;
+  /// The loops executed by the stage threads, one per thread
+  std::vector<std::function<void()>> m_loops;
+  std::mutex m_mutex;
+  std::exception_ptr m_exception;
+  std::atomic<bool> m_cancelled;
+  bool m_started;
+
+}; /* End of Pipeline class */
+
+} /* namespace Euclid */
+
+#include "AlexandriaKernel/_impl/Pipeline.icpp"
+
+#endif /* _ALEXANDRIAKERNEL_PIPELINE_H */
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file AlexandriaKernel/TaskGroup.h
+ * @author nikoapos
+ */
+
+#ifndef _ALEXANDRIAKERNEL_TASKGROUP_H
+#define _ALEXANDRIAKERNEL_TASKGROUP_H
+
+#include <memory>
+#include "AlexandriaKernel/CancellationToken.h"
+#include "AlexandriaKernel/ThreadPool.h"
+
+namespace Euclid {
+
+/**
+ * @class TaskGroup
+ *
+ * @brief A set of tasks executed by a ThreadPool that can be waited for independently
+ *
+ * @details
+ * ThreadPool::block() waits for all the tasks in the pool. A TaskGroup
+ * allows several independent stages to share the same pool, each one waiting
+ * only for its own tasks.
+ *
+ * Exceptions are handled per group: if a task of the group throws, the
+ * exception is kept by the group (the pool keeps running), the tasks of the
+ * group not yet started are skipped, and the exception is rethrown by wait().
+ *
+ * A group can be cancelled with cancel(): the tasks of the group not yet
+ * started are skipped, and the running ones can poll the token returned by
+ * cancellationToken() to stop early. The group tasks discarded by the pool
+ * (see ThreadPool::discardPending()) count as finished.
+ *
+ * The destructor waits for the tasks of the group to finish, but it does not
+ * rethrow their exceptions.
+ *
+ * Groups can be nested: when wait() (or the destructor) is called from a
+ * worker of the same pool, the worker runs queued tasks until the group is
+ * finished, instead of sleeping. Note that with ExceptionPolicy::STOP, a
+ * failure of a task outside the group pauses the pool, so the group only
+ * finishes after ThreadPool::clearExceptions().
+ */
+class TaskGroup {
+
+public:
+
+  /**
+   * @brief Constructor
+   * @param pool
+   *    The pool that will execute the tasks. It must outlive the group.
+   * @param token
+   *    Token used to cancel the group. Passing an existing token allows to
+   *    cancel several groups at once.
+   */
+  explicit TaskGroup(ThreadPool& pool, CancellationToken token = CancellationToken{});
+
+  /// Waits for the tasks of the group to finish
+  virtual ~TaskGroup();
+
+  /// Submit a task to be executed as part of this group
+  void submit(ThreadPool::Task task);
+
+  /// Blocks the calling thread until all the tasks of the group are finished,
+  /// and rethrows the exception of the first task that failed, if any
+  void wait();
+
+  /// Checks if any task of the group has thrown an exception and optionally rethrows it
+  bool checkForException(bool rethrow=false);
+
+  /// Skips the tasks of the group not yet started, and cancels the group token
+  void cancel();
+
+  /// Token cancelled by cancel(), to be polled by long running tasks
+  CancellationToken cancellationToken() const;
+
+private:
+
+  struct State;
+
+  void waitForPending();
+
+  ThreadPool& m_pool;
+  std::shared_ptr<State> m_state;
+
+}; /* End of TaskGroup class */
+
+} /* namespace Euclid */
+
+#endif /* _ALEXANDRIAKERNEL_TASKGROUP_H */
@@ -25,13 +25,20 @@
 #ifndef _ALEXANDRIAKERNEL_THREADPOOL_H
 #define _ALEXANDRIAKERNEL_THREADPOOL_H
 
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <memory>
 #include <deque>
 #include <functional>
 #include <exception>
+#include <future>
+#include <type_traits>
 
 namespace Euclid {
 
@@ -55,6 +62,51 @@ namespace Euclid {
  * same order as they are submitted. To block until all the tasks in the pool
  * have been executed, one can all the ThreadPool::block() method.
  *
+ * The worker threads are event driven: idle workers block on a condition
+ * variable and are woken up as soon as a task is submitted, so they do not
+ * consume any CPU while waiting, and the ThreadPool::block() method returns as
+ * soon as the last task finishes.
+ *
+ * By default all the workers share a single FIFO queue. For fine grained tasks
+ * running on many cores that queue becomes a contention point, so the pool can
+ * be constructed with the Scheduling::WORK_STEALING policy instead. In this
+ * mode each worker owns its own deque: tasks submitted from inside a task go to
+ * the deque of the worker running it, tasks submitted from outside the pool
+ * are distributed in round-robin, and idle workers steal the oldest tasks from
+ * the other deques. Note that in this mode the order of execution is not
+ * guaranteed to match the order of submission.
+ *
+ * Callables returning a value can also be submitted. In this case submit()
+ * returns a std::future for the result, and any exception thrown by the
+ * callable is stored in the future instead of stopping the pool. To wait for
+ * a subset of the tasks, without waiting for the whole pool, use a TaskGroup.
+ *
+ * By default the queue is unbounded. When a producer can generate tasks much
+ * faster than the workers can consume them (i.e. one task per chunk read from a
+ * file), a capacity can be set with setQueueCapacity(). Then submit() blocks
+ * while the queue is full, and trySubmit() returns false, so the memory held by
+ * the queued tasks is bounded. Tasks submitted from inside the pool workers
+ * never block, as that could deadlock the pool.
+ *
+ * The workers can be pinned to specific CPUs with setPlacement(), either
+ * following a policy (Placement::COMPACT fills one NUMA node before moving to
+ * the next, Placement::SCATTER distributes the workers across the nodes) or an
+ * explicit list of CPUs. Tasks can use currentWorkerIndex() to select per
+ * worker (and thus NUMA local) scratch buffers. Placement is only supported on
+ * Linux, and ignored elsewhere.
+ *
+ * Tasks can submit more tasks and wait for them, calling block() or
+ * TaskGroup::wait(), without deadlocking the pool: when called from a worker,
+ * these methods run queued tasks while waiting, instead of sleeping. Note that
+ * block() called from a task waits for all the other tasks, except those also
+ * waiting in block(). Libraries that want to run in parallel without creating
+ * their own threads can use the process wide pool returned by defaultPool().
+ *
+ * For sizing the pool and the tasks, the pool can collect metrics (number of
+ * tasks, time spent in the queue and running, busy ratio of each worker and
+ * peak queue length). They are disabled by default, and can be enabled with
+ * enableMetrics() and retrieved with metrics().
+ *
  * Note that when the ThreadPool object goes out of scope and its destructor is
  * called it will not process any tasks that are not already started, but it will
  * block until all threads finish with the currently executing tasks.
@@ -62,7 +114,15 @@ namespace Euclid {
  * If any of the tasks in the queue throws an exception, all other running tasks
  * will finish their execution, but no new tasks will be started. In this case,
  * the block() method will rethrow the exception. The pool can be checked if it
- * is in an exception state by calling the checkForException() method.
+ * is in an exception state by calling the checkForException() method. The queued
+ * tasks are kept, and the processing resumes after calling clearExceptions().
+ * Alternatively, with the ExceptionPolicy::COLLECT policy the pool keeps
+ * running: all the exceptions are collected, block() waits for all the tasks
+ * and then rethrows the first exception, and exceptions() returns all of them.
+ *
+ * The tasks not yet started can be removed from the queue with discardPending(),
+ * or retrieved with drainPending(). To stop tasks that are already running,
+ * pass them a CancellationToken they can poll.
  *
  */
 class ThreadPool {
@@ -72,44 +132,290 @@ public:
   /// The type of tasks the pool can execute
   using Task = std::function<void(void)>;
 
+  /// How the tasks are distributed between the workers
+  enum class Scheduling {
+    /// All the workers share a single queue, and tasks are started in the order they are submitted
+    FIFO,
+    /// Each worker has its own deque, and idle workers steal tasks from the others
+    WORK_STEALING
+  };
+
+  /// How the workers are pinned to the CPUs
+  enum class Placement {
+    /// Let the operating system decide
+    NONE,
+    /// Consecutive workers share the same NUMA node, which is filled before moving to the next
+    COMPACT,
+    /// Consecutive workers are distributed in round-robin across the NUMA nodes
+    SCATTER
+  };
+
+  /// What to do when a task throws an exception
+  enum class ExceptionPolicy {
+    /// Do not start more tasks until clearExceptions() is called
+    STOP,
+    /// Keep running the remaining tasks, collecting all the exceptions
+    COLLECT
+  };
+
+  /**
+   * Histogram of durations with logarithmic bins: the bin 0 counts durations
+   * below 1 microsecond, the bin i durations within [2^(i-1), 2^i) microseconds,
+   * and the last bin everything above.
+   */
+  struct DurationHistogram {
+    static constexpr std::size_t BINS = 32;
+
+    std::array<std::uint64_t, BINS> counts;
+    /// Sum of all the recorded durations
+    std::chrono::nanoseconds total;
+
+    /// Upper (exclusive) edge of the given bin
+    static std::chrono::microseconds upperEdge(std::size_t bin);
+  };
+
+  /// Snapshot of the pool metrics, as returned by ThreadPool::metrics()
+  struct Metrics {
+    /// Tasks submitted
+    std::uint64_t submitted;
+    /// Tasks that finished without an exception
+    std::uint64_t completed;
+    /// Tasks that finished with an exception
+    std::uint64_t failed;
+    /// Tasks waiting in the queues when the snapshot was taken
+    std::size_t queue_length;
+    /// Maximum number of tasks waiting in the queues
+    std::size_t peak_queue_length;
+    /// Time between the submission and the start of the tasks
+    DurationHistogram queue_wait;
+    /// Execution time of the tasks
+    DurationHistogram run_time;
+    /// Fraction of the time each worker spent running tasks
+    std::vector<double> busy_ratio;
+    /// Time covered by the metrics
+    std::chrono::nanoseconds elapsed;
+  };
+
   /**
    * @brief Constructs a new ThreadPool
    * @param thread_count
    *    The number of threads in the pool (defaults to the number of available cores)
    * @param empty_queue_wait_time
-   *    The time (in milliseconds) the pool threads sleep after they try to get
-   *    a task from an empty queue before they retry
+   *    Ignored. Kept only for backwards compatibility with the time based
+   *    polling implementation, as the workers are now notified when new tasks
+   *    are submitted
    */
   explicit ThreadPool(unsigned int thread_count = std::thread::hardware_concurrency(),
                       unsigned int empty_queue_wait_time = 50);
 
+  /**
+   * @brief Constructs a new ThreadPool using the given scheduling policy
+   * @param thread_count
+   *    The number of threads in the pool
+   * @param scheduling
+   *    How the tasks are distributed between the workers
+   */
+  ThreadPool(unsigned int thread_count, Scheduling scheduling);
+
   /// All tasks not yet started are discarded and it blocks until all already
   /// executing tasks are finished
   virtual ~ThreadPool();
 
-  /// Submit a task to be executed
+  /// Submit a task to be executed. If the queue capacity is reached, it blocks
+  /// until a worker takes a task from the queue.
   void submit(Task task);
 
+  /// Submit a task to be executed only if the queue capacity is not reached
+  /// @return true if the task has been queued, false if the queue is full
+  bool trySubmit(Task task);
+
+  /**
+   * @brief Submit a callable returning a value to be executed
+   * @param callable
+   *    Anything callable without parameters and returning a non void type
+   * @return
+   *    A future that will contain the value returned by the callable, or the
+   *    exception it has thrown. Note that, unlike for void tasks, the exception
+   *    is *not* reported to the pool, and the pool keeps running.
+   */
+  template <typename F, typename R = typename std::result_of<F()>::type,
+            typename = typename std::enable_if<!std::is_void<R>::value>::type>
+  std::future<R> submit(F&& callable);
+
   /// Blocks the calling thread until all the tasks in the pool queue are finished.
-  /// Note that submitting tasks until this method returns is not allowed.
+  /// Note that submitting tasks until this method returns is not allowed, except
+  /// from the tasks themselves. If called from a task, it runs queued tasks while waiting.
   void block();
 
   /// Checks if any task has thrown an exception and optionally rethrows it
   bool checkForException(bool rethrow=false);
 
+  /// Sets what to do when a task throws an exception. The default is ExceptionPolicy::STOP.
+  void setExceptionPolicy(ExceptionPolicy policy);
+
+  /// Gets all the exceptions thrown by the tasks, in the order they were caught
+  std::vector<std::exception_ptr> exceptions() const;
+
+  /// Forgets the exceptions thrown so far. With ExceptionPolicy::STOP, this
+  /// also resumes the processing of the queued tasks.
+  void clearExceptions();
+
+  /// Removes from the queue the tasks not yet started and returns them,
+  /// so they can be resubmitted later
+  std::vector<Task> drainPending();
+
+  /// Removes from the queue and destroys the tasks not yet started
+  /// @return The number of discarded tasks
+  std::size_t discardPending();
+
+  /// Number of worker threads in the pool
+  unsigned int threadCount() const;
+
+  /**
+   * @brief Pins the workers to the CPUs following the given policy
+   * @details
+   *    Only the CPUs the process is allowed to run on are used. If there are
+   *    more workers than CPUs, several workers share the same CPU.
+   * @throws Elements::Exception
+   *    If the affinity of a worker can not be set
+   */
+  void setPlacement(Placement placement);
+
+  /**
+   * @brief Pins the worker i to the CPU cpus[i % cpus.size()]
+   * @throws Elements::Exception
+   *    If the list is empty or the affinity of a worker can not be set
+   */
+  void setPlacement(const std::vector<unsigned int>& cpus);
+
+  /// Index, within its pool, of the worker running the calling thread, or -1 if
+  /// the calling thread is not a pool worker
+  static int currentWorkerIndex();
+
+  /// The pool owning the worker running the calling thread, or nullptr if the
+  /// calling thread is not a pool worker
+  static ThreadPool* currentPool();
+
+  /// A process wide pool using work stealing, with one worker per core,
+  /// created the first time it is requested
+  static ThreadPool& defaultPool();
+
+  /**
+   * @brief Runs queued tasks until the given condition is met
+   * @details
+   *    Building block for waiting from inside a task without blocking a worker.
+   *    When there are no queued tasks, the calling thread sleeps until a task
+   *    is submitted or finished, so whatever makes done() true must be followed
+   *    by either of those, or by a call to wakeUpHelpers().
+   * @throws Elements::Exception
+   *    If the calling thread is not a worker of this pool
+   */
+  void helpUntil(const std::function<bool()>& done);
+
+  /// Wakes up the threads waiting in helpUntil(), so they re-evaluate their condition
+  void wakeUpHelpers();
+
+  /// Sets the maximum number of tasks waiting in the queue. 0 means unbounded.
+  void setQueueCapacity(std::size_t capacity);
+
+  /**
+   * @brief Enables or disables the collection of metrics
+   * @details
+   *    Enabling the metrics resets them. Tasks submitted while the metrics are
+   *    disabled are not accounted for the queue wait time.
+   */
+  void enableMetrics(bool enable=true);
+
+  /// Gets a snapshot of the metrics collected since they were enabled
+  Metrics metrics() const;
+
 private:
 
-  std::mutex m_queue_mutex;
-  std::vector<std::atomic<bool>> m_worker_run_flags;
-  std::vector<std::atomic<bool>> m_worker_sleeping_flags;
-  std::vector<std::atomic<bool>> m_worker_done_flags;
-  std::deque<Task> m_queue;
-  unsigned int m_empty_queue_wait_time;
-  std::exception_ptr m_exception_ptr;
+  using Clock = std::chrono::steady_clock;
+
+  struct QueuedTask {
+    Task task;
+    /// Only set when the metrics are enabled
+    Clock::time_point submitted;
+  };
+
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<QueuedTask> tasks;
+  };
+
+  /// Metrics recorded by a single worker
+  struct WorkerMetrics {
+    std::atomic<std::uint64_t> completed, failed, busy_ns, queue_wait_ns, run_ns;
+    std::array<std::atomic<std::uint64_t>, DurationHistogram::BINS> queue_wait_bins, run_bins;
+
+    void reset();
+  };
+
+  /// The loop executed by each of the worker threads
+  void workerLoop(unsigned int worker_index);
+
+  /// Gets the next task for the given worker, stealing it from another worker if needed
+  bool popTask(unsigned int worker_index, QueuedTask& task);
+
+  /// Moves the task out of the queue, keeping the counters up to date. The queue must be locked.
+  void takeTask(std::deque<QueuedTask>& tasks, bool from_back, QueuedTask& task);
+
+  /// Runs a task taken from the queue, updating the counters, metrics and exceptions
+  void runTask(QueuedTask& task);
+
+  /// Reserves a place in the queue, waiting for it if blocking is true
+  bool reserveQueueSlot(bool blocking);
+
+  /// Puts the task in the corresponding queue. A slot must have been reserved.
+  void enqueue(Task task);
+
+  Scheduling m_scheduling;
+  /// A single shared queue for FIFO scheduling, one per worker for work stealing
+  std::vector<std::unique_ptr<TaskQueue>> m_queues;
+  std::vector<std::thread> m_workers;
+
+  /// Tasks waiting in the queues
+  std::atomic<std::size_t> m_queued_tasks;
+  /// Tasks currently executing
+  std::atomic<std::size_t> m_running_tasks;
+  /// Tasks either waiting or executing
+  std::atomic<std::size_t> m_unfinished_tasks;
+  std::atomic<std::size_t> m_queue_capacity;
+  std::atomic<unsigned int> m_sleeping_workers;
+  std::atomic<unsigned int> m_waiting_producers;
+  std::atomic<unsigned int> m_waiting_helpers;
+  /// Tasks waiting for the rest within block()
+  std::atomic<std::size_t> m_blocking_workers;
+  std::atomic<unsigned int> m_next_queue;
+  std::atomic<bool> m_stop;
+  std::atomic<bool> m_failed;
+
+  /// Protects the exception and the condition variables used for sleeping
+  mutable std::mutex m_state_mutex;
+  /// Notified when a new task is submitted or when the workers must stop
+  std::condition_variable m_task_available;
+  /// Notified when a worker finishes a task and there is no more work to do
+  std::condition_variable m_workers_idle;
+  /// Notified when a worker takes a task from the queue and producers are waiting
+  std::condition_variable m_space_available;
+  /// Notified when a task is submitted or finished and there are threads within helpUntil()
+  std::condition_variable m_helpers_wakeup;
+  ExceptionPolicy m_exception_policy;
+  std::vector<std::exception_ptr> m_exceptions;
+
+  std::atomic<bool> m_metrics_enabled;
+  std::atomic<std::uint64_t> m_submitted_tasks;
+  std::atomic<std::size_t> m_peak_queued_tasks;
+  /// One per worker, allocated separately to avoid false sharing
+  std::vector<std::unique_ptr<WorkerMetrics>> m_worker_metrics;
+  /// When the metrics were enabled. Protected by m_state_mutex.
+  Clock::time_point m_metrics_start;
 
 }; /* End of ThreadPool class */
 
 } /* namespace Euclid */
 
+#include "AlexandriaKernel/_impl/ThreadPool.icpp"
 
 #endif
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file src/lib/Pipeline.cpp
+ * @author nikoapos
+ */
+
+#include <thread>
+#include "ElementsKernel/Exception.h"
+#include "AlexandriaKernel/Pipeline.h"
+
+namespace Euclid {
+
+Pipeline::Pipeline(std::size_t queue_capacity)
+        : m_queue_capacity(queue_capacity), m_cancelled(false), m_started(false) {
+}
+
+void Pipeline::consume(Pipeline_Impl::ChannelBase& channel) {
+  if (m_started) {
+    throw Elements::Exception() << "Stages can not be added to a pipeline already run";
+  }
+  if (channel.consumed) {
+    throw Elements::Exception() << "The output of a pipeline stage can have only one consumer";
+  }
+  channel.consumed = true;
+}
+
+void Pipeline::run() {
+  if (m_started) {
+    throw Elements::Exception() << "A pipeline can be run only once";
+  }
+  for (auto& channel : m_channels) {
+    if (!channel->consumed) {
+      throw Elements::Exception() << "The output of a pipeline stage is not consumed";
+    }
+  }
+  m_started = true;
+
+  std::vector<std::thread> threads;
+  threads.reserve(m_loops.size());
+  try {
+    for (auto& loop : m_loops) {
+      threads.emplace_back(&Pipeline::runStage, this, std::cref(loop));
+    }
+  } catch (...) {
+    // Could not start all the threads, so stop the ones already running
+    fail(std::current_exception());
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::lock_guard<std::mutex> lock {m_mutex};
+  if (m_exception) {
+    std::rethrow_exception(m_exception);
+  }
+}
+
+void Pipeline::cancel() {
+  m_cancelled = true;
+  for (auto& channel : m_channels) {
+    channel->abort();
+  }
+}
+
+void Pipeline::runStage(const std::function<void()>& loop) {
+  try {
+    loop();
+  } catch (...) {
+    fail(std::current_exception());
+  }
+}
+
+void Pipeline::fail(std::exception_ptr exception) {
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    if (m_exception == nullptr) {
+      m_exception = exception;
+    }
+  }
+  cancel();
+}
+
+} // Euclid namespace
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file src/lib/TaskGroup.cpp
+ * @author nikoapos
+ */
+
+#include <atomic>
+#include "AlexandriaKernel/TaskGroup.h"
+
+namespace Euclid {
+
+struct TaskGroup::State {
+  explicit State(ThreadPool& pool) : pool(pool) {
+  }
+
+  ThreadPool& pool;
+  std::mutex mutex;
+  std::condition_variable done;
+  /// Modified only while holding the mutex, but read without it by the
+  /// workers waiting for the group within ThreadPool::helpUntil()
+  std::atomic<std::size_t> pending {0};
+  std::exception_ptr exception_ptr;
+  CancellationToken token;
+};
+
+namespace {
+
+/// Marks a task of the group as finished when destroyed, so the group is
+/// notified even if the pool discards the task without running it
+template <typename State>
+class Ticket {
+
+public:
+
+  explicit Ticket(std::shared_ptr<State> state) : m_state(std::move(state)) {
+  }
+
+  ~Ticket() {
+    std::lock_guard<std::mutex> lock {m_state->mutex};
+    if (--m_state->pending == 0) {
+      m_state->done.notify_all();
+      // Still holding the mutex, so the pool can not be destroyed by a
+      // thread returning from wait() in the meantime
+      m_state->pool.wakeUpHelpers();
+    }
+  }
+
+  State& state() {
+    return *m_state;
+  }
+
+private:
+
+  std::shared_ptr<State> m_state;
+
+};
+
+/// Wraps a task so its exceptions are reported to the group instead of to the pool
+template <typename State>
+class GroupTask {
+
+public:
+
+  GroupTask(std::shared_ptr<State> state, ThreadPool::Task task)
+        : m_ticket(std::make_shared<Ticket<State>>(std::move(state))), m_task(std::move(task)) {
+  }
+
+  void operator()() {
+    auto& state = m_ticket->state();
+    bool skip;
+    {
+      std::lock_guard<std::mutex> lock {state.mutex};
+      skip = (state.exception_ptr != nullptr || state.token.isCancelled());
+    }
+
+    std::exception_ptr task_exception;
+    if (!skip) {
+      try {
+        m_task();
+      } catch (...) {
+        task_exception = std::current_exception();
+      }
+    }
+    m_task = nullptr;
+
+    if (task_exception != nullptr) {
+      std::lock_guard<std::mutex> lock {state.mutex};
+      if (state.exception_ptr == nullptr) {
+        state.exception_ptr = task_exception;
+      }
+    }
+  }
+
+private:
+
+  std::shared_ptr<Ticket<State>> m_ticket;
+  ThreadPool::Task m_task;
+
+};
+
+} // end of anonymous namespace
+
+TaskGroup::TaskGroup(ThreadPool& pool, CancellationToken token)
+        : m_pool(pool), m_state(std::make_shared<State>(pool)) {
+  m_state->token = std::move(token);
+}
+
+TaskGroup::~TaskGroup() {
+  waitForPending();
+}
+
+void TaskGroup::waitForPending() {
+  // From a worker of the pool, run other tasks meanwhile, so nested groups
+  // can not exhaust the workers
+  if (ThreadPool::currentPool() == &m_pool) {
+    auto state = m_state;
+    m_pool.helpUntil([state]() { return state->pending == 0; });
+    // Wait for the last ticket to release the mutex
+    std::lock_guard<std::mutex> lock {m_state->mutex};
+    return;
+  }
+  std::unique_lock<std::mutex> lock {m_state->mutex};
+  m_state->done.wait(lock, [this]() { return m_state->pending == 0; });
+}
+
+void TaskGroup::submit(ThreadPool::Task task) {
+  {
+    std::lock_guard<std::mutex> lock {m_state->mutex};
+    ++m_state->pending;
+  }
+  m_pool.submit(GroupTask<State>{m_state, std::move(task)});
+}
+
+void TaskGroup::wait() {
+  waitForPending();
+  checkForException(true);
+}
+
+void TaskGroup::cancel() {
+  m_state->token.cancel();
+}
+
+CancellationToken TaskGroup::cancellationToken() const {
+  return m_state->token;
+}
+
+bool TaskGroup::checkForException(bool rethrow) {
+  std::unique_lock<std::mutex> lock {m_state->mutex};
+  if (m_state->exception_ptr) {
+    if (rethrow) {
+      auto exception_ptr = m_state->exception_ptr;
+      lock.unlock();
+      std::rethrow_exception(exception_ptr);
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // Euclid namespace
@@ -22,6 +22,17 @@
  * @author nikoapos
  */
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "ElementsKernel/Exception.h"
 #include "AlexandriaKernel/ThreadPool.h"
 #include "AlexandriaKernel/memory_tools.h"
 
@@ -29,92 +40,330 @@ namespace Euclid {
 
 namespace {
 
-class Worker {
+/// The pool owning the worker running on this thread, if any
+thread_local ThreadPool* s_current_pool = nullptr;
+/// The index of the worker running on this thread
+thread_local unsigned int s_current_worker = 0;
 
-public:
+/// Bin of ThreadPool::DurationHistogram where the duration falls
+std::size_t durationBin(std::chrono::nanoseconds duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  std::size_t bin = 0;
+  while (us > 0 && bin < ThreadPool::DurationHistogram::BINS - 1) {
+    us >>= 1;
+    ++bin;
+  }
+  return bin;
+}
+
+void recordDuration(std::atomic<std::uint64_t>& total,
+                    std::array<std::atomic<std::uint64_t>, ThreadPool::DurationHistogram::BINS>& bins,
+                    std::chrono::nanoseconds duration) {
+  total.fetch_add(duration.count(), std::memory_order_relaxed);
+  bins[durationBin(duration)].fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef __linux__
 
-  Worker(std::mutex& queue_mutex, std::deque<ThreadPool::Task>& queue,
-                  std::atomic<bool>& run_flag, std::atomic<bool>& sleeping_flag,
-                  std::atomic<bool>& done_flag, unsigned int empty_queue_wait_time,
-                  std::exception_ptr& exception_ptr)
-        : m_queue_mutex(queue_mutex), m_queue(queue), m_run_flag(run_flag),
-          m_sleeping_flag(sleeping_flag), m_done_flag(done_flag),
-          m_empty_queue_wait_time(empty_queue_wait_time),
-          m_exception_ptr(exception_ptr) {
+/// Parses a sysfs CPU list, like "0-3,8-11"
+std::vector<unsigned int> parseCpuList(const std::string& cpulist) {
+  std::vector<unsigned int> cpus;
+  std::stringstream stream(cpulist);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    auto dash = range.find('-');
+    unsigned int first = std::stoul(range.substr(0, dash));
+    unsigned int last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+    for (unsigned int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
   }
+  return cpus;
+}
 
-  void operator()() {
-    while (m_run_flag.get() && m_exception_ptr == nullptr) {
-      // Check if there is anything it the queue to be done and get it
-      std::unique_ptr<ThreadPool::Task> task_ptr = nullptr;
-      std::unique_lock<std::mutex> lock {m_queue_mutex.get()};
-      if (!m_queue.get().empty()) {
-        task_ptr = Euclid::make_unique<ThreadPool::Task>(m_queue.get().front());
-        m_queue.get().pop_front();
+/// The CPUs the process can run on, grouped by NUMA node
+std::vector<std::vector<unsigned int>> allowedCpusByNode() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    throw Elements::Exception() << "Failed to get the process CPU affinity";
+  }
+
+  std::vector<std::vector<unsigned int>> nodes;
+  if (DIR* node_dir = opendir("/sys/devices/system/node")) {
+    std::vector<unsigned int> node_ids;
+    while (dirent* entry = readdir(node_dir)) {
+      std::string name = entry->d_name;
+      if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+          std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+        node_ids.push_back(std::stoul(name.substr(4)));
       }
-      lock.unlock();
+    }
+    closedir(node_dir);
+    std::sort(node_ids.begin(), node_ids.end());
 
-      // If we have some work to do, do it. Otherwise sleep for some time.
-      if (task_ptr) {
-        try {
-          (*task_ptr)();
-        } catch(...) {
-          m_exception_ptr.get() = std::current_exception();
+    for (auto id : node_ids) {
+      std::ifstream cpulist_file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+      std::string cpulist;
+      std::getline(cpulist_file, cpulist);
+      std::vector<unsigned int> node_cpus;
+      for (auto cpu : parseCpuList(cpulist)) {
+        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+          node_cpus.push_back(cpu);
         }
-      } else {
-        m_sleeping_flag.get() = true;
-        std::this_thread::sleep_for(std::chrono::milliseconds(m_empty_queue_wait_time));
-        m_sleeping_flag.get() = false;
+      }
+      if (!node_cpus.empty()) {
+        nodes.emplace_back(std::move(node_cpus));
       }
     }
-    // Indicate that the worker is done
-    m_sleeping_flag.get() = true;
-    m_done_flag.get() = true;
   }
 
-private:
+  // No NUMA information, consider all the CPUs as a single node
+  if (nodes.empty()) {
+    nodes.emplace_back();
+    for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        nodes.back().push_back(cpu);
+      }
+    }
+  }
+  return nodes;
+}
 
-  std::reference_wrapper<std::mutex> m_queue_mutex;
-  std::reference_wrapper<std::deque<ThreadPool::Task>> m_queue;
-  std::reference_wrapper<std::atomic<bool>> m_run_flag;
-  std::reference_wrapper<std::atomic<bool>> m_sleeping_flag;
-  std::reference_wrapper<std::atomic<bool>> m_done_flag;
-  unsigned int m_empty_queue_wait_time;
-  std::reference_wrapper<std::exception_ptr> m_exception_ptr;
+void setThreadAffinity(std::thread& thread, const cpu_set_t& cpu_set) {
+  int ret = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+  if (ret != 0) {
+    throw Elements::Exception() << "Failed to set the CPU affinity of a worker: " << std::strerror(ret);
+  }
+}
 
-};
+#endif
 
 } // end of anonymous namespace
 
-ThreadPool::ThreadPool(unsigned int thread_count, unsigned int empty_queue_wait_time)
-        : m_worker_run_flags(thread_count), m_worker_sleeping_flags(thread_count),
-          m_worker_done_flags(thread_count), m_empty_queue_wait_time(empty_queue_wait_time) {
+constexpr std::size_t ThreadPool::DurationHistogram::BINS;
+
+std::chrono::microseconds ThreadPool::DurationHistogram::upperEdge(std::size_t bin) {
+  if (bin >= BINS - 1) {
+    return std::chrono::microseconds::max();
+  }
+  return std::chrono::microseconds(std::int64_t{1} << bin);
+}
+
+void ThreadPool::WorkerMetrics::reset() {
+  completed = 0;
+  failed = 0;
+  busy_ns = 0;
+  queue_wait_ns = 0;
+  run_ns = 0;
+  for (auto& bin : queue_wait_bins) {
+    bin = 0;
+  }
+  for (auto& bin : run_bins) {
+    bin = 0;
+  }
+}
+
+ThreadPool::ThreadPool(unsigned int thread_count, unsigned int)
+        : ThreadPool(thread_count, Scheduling::FIFO) {
+}
+
+ThreadPool::ThreadPool(unsigned int thread_count, Scheduling scheduling)
+        : m_scheduling(scheduling), m_queued_tasks(0), m_running_tasks(0), m_unfinished_tasks(0),
+          m_queue_capacity(0), m_sleeping_workers(0), m_waiting_producers(0), m_waiting_helpers(0),
+          m_blocking_workers(0), m_next_queue(0), m_stop(false), m_failed(false),
+          m_exception_policy(ExceptionPolicy::STOP), m_metrics_enabled(false), m_submitted_tasks(0), m_peak_queued_tasks(0) {
+  unsigned int queue_count = (scheduling == Scheduling::WORK_STEALING) ? std::max(thread_count, 1u) : 1u;
+  for (unsigned int i = 0; i < queue_count; ++i) {
+    m_queues.emplace_back(Euclid::make_unique<TaskQueue>());
+  }
+  for (unsigned int i = 0; i < thread_count; ++i) {
+    m_worker_metrics.emplace_back(Euclid::make_unique<WorkerMetrics>());
+    m_worker_metrics.back()->reset();
+  }
+  m_workers.reserve(thread_count);
   for (unsigned int i = 0; i < thread_count; ++i) {
-    m_worker_run_flags.at(i) = true;
-    m_worker_sleeping_flags.at(i) = false;
-    m_worker_done_flags.at(i) = false;
-    std::thread(Worker{m_queue_mutex, m_queue, m_worker_run_flags.at(i), m_worker_sleeping_flags.at(i),
-                       m_worker_done_flags.at(i), m_empty_queue_wait_time, m_exception_ptr}).detach();
+    m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
   }
 }
 
-namespace {
+void ThreadPool::takeTask(std::deque<QueuedTask>& tasks, bool from_back, QueuedTask& task) {
+  if (from_back) {
+    task = std::move(tasks.back());
+    tasks.pop_back();
+  } else {
+    task = std::move(tasks.front());
+    tasks.pop_front();
+  }
+  // Increase first the running counter, so the task is always accounted for
+  ++m_running_tasks;
+  --m_queued_tasks;
+}
 
-void waitWorkers(std::vector<std::atomic<bool>>& worker_flags, unsigned int wait_time) {
-  // Now wait until all the workers have finish any current tasks
-  for (auto& flag : worker_flags) {
-    while (!flag) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(wait_time));
+bool ThreadPool::popTask(unsigned int worker_index, QueuedTask& task) {
+  if (m_scheduling == Scheduling::FIFO) {
+    auto& queue = *m_queues.front();
+    std::lock_guard<std::mutex> lock {queue.mutex};
+    if (queue.tasks.empty()) {
+      return false;
+    }
+    takeTask(queue.tasks, false, task);
+    return true;
+  }
+
+  // Start with our own deque, taking the newest task, which is the most likely
+  // to have its data still in cache
+  {
+    auto& own = *m_queues[worker_index];
+    std::lock_guard<std::mutex> lock {own.mutex};
+    if (!own.tasks.empty()) {
+      takeTask(own.tasks, true, task);
+      return true;
+    }
+  }
+
+  // Steal the oldest task from another worker. Busy deques are skipped, as
+  // the worker will retry for as long as there are queued tasks.
+  auto queue_count = m_queues.size();
+  for (std::size_t i = 1; i < queue_count; ++i) {
+    auto& victim = *m_queues[(worker_index + i) % queue_count];
+    std::unique_lock<std::mutex> lock {victim.mutex, std::try_to_lock};
+    if (lock.owns_lock() && !victim.tasks.empty()) {
+      takeTask(victim.tasks, false, task);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(unsigned int worker_index) {
+  s_current_pool = this;
+  s_current_worker = worker_index;
+
+  QueuedTask task;
+  while (!m_stop) {
+    // After a failure no more tasks are started until the exceptions are cleared
+    if (m_failed || !popTask(worker_index, task)) {
+      // Sleep until there is something to do, or we are asked to stop.
+      // The sleeping counter is increased before checking for queued tasks,
+      // so submit() can not miss this worker.
+      std::unique_lock<std::mutex> lock {m_state_mutex};
+      ++m_sleeping_workers;
+      m_task_available.wait(lock, [this]() {
+        return m_stop || (!m_failed && m_queued_tasks > 0);
+      });
+      --m_sleeping_workers;
+      continue;
+    }
+    runTask(task);
+  }
+}
+
+void ThreadPool::runTask(QueuedTask& task) {
+  auto& metrics = *m_worker_metrics[s_current_worker];
+
+  // A place in the queue has been released
+  if (m_waiting_producers > 0) {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_space_available.notify_one();
+  }
+
+  bool record_metrics = m_metrics_enabled.load(std::memory_order_relaxed);
+  Clock::time_point start;
+  if (record_metrics) {
+    start = Clock::now();
+    if (task.submitted != Clock::time_point{}) {
+      recordDuration(metrics.queue_wait_ns, metrics.queue_wait_bins, start - task.submitted);
+    }
+  }
+
+  std::exception_ptr task_exception;
+  try {
+    task.task();
+  } catch (...) {
+    task_exception = std::current_exception();
+  }
+  // Release whatever the task holds before reporting it as finished
+  task.task = nullptr;
+
+  if (record_metrics) {
+    auto run_time = Clock::now() - start;
+    recordDuration(metrics.run_ns, metrics.run_bins, run_time);
+    metrics.busy_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(run_time).count(),
+                              std::memory_order_relaxed);
+    if (task_exception) {
+      ++metrics.failed;
+    } else {
+      ++metrics.completed;
+    }
+  }
+
+  if (task_exception != nullptr) {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_exceptions.emplace_back(task_exception);
+    if (m_exception_policy == ExceptionPolicy::STOP && !m_failed) {
+      m_failed = true;
+      // Wake up the producers waiting for a queue that will not be consumed anymore
+      m_space_available.notify_all();
+    }
+  }
+
+  --m_running_tasks;
+  if (--m_unfinished_tasks == 0 || m_failed) {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_workers_idle.notify_all();
+  }
+  wakeUpHelpers();
+}
+
+void ThreadPool::helpUntil(const std::function<bool()>& done) {
+  if (s_current_pool != this) {
+    throw Elements::Exception() << "Only the pool workers can help the pool";
+  }
+
+  QueuedTask task;
+  while (!done()) {
+    if (!m_stop && !m_failed && popTask(s_current_worker, task)) {
+      runTask(task);
+      continue;
     }
+    // Same as for the sleeping workers, the counter is increased before
+    // checking the condition, so wakeUpHelpers() can not miss this thread
+    std::unique_lock<std::mutex> lock {m_state_mutex};
+    ++m_waiting_helpers;
+    m_helpers_wakeup.wait(lock, [this, &done]() {
+      return done() || m_stop || (!m_failed && m_queued_tasks > 0);
+    });
+    --m_waiting_helpers;
+    if (m_stop) {
+      break;
+    }
+  }
+}
+
+void ThreadPool::wakeUpHelpers() {
+  if (m_waiting_helpers > 0) {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_helpers_wakeup.notify_all();
   }
 }
 
+ThreadPool* ThreadPool::currentPool() {
+  return s_current_pool;
+}
+
+ThreadPool& ThreadPool::defaultPool() {
+  static ThreadPool pool {std::max(std::thread::hardware_concurrency(), 1u), Scheduling::WORK_STEALING};
+  return pool;
 }
 
 bool ThreadPool::checkForException(bool rethrow) {
-  if (m_exception_ptr) {
+  std::unique_lock<std::mutex> lock {m_state_mutex};
+  if (!m_exceptions.empty()) {
     if (rethrow) {
-      std::rethrow_exception(m_exception_ptr);
+      auto exception_ptr = m_exceptions.front();
+      lock.unlock();
+      std::rethrow_exception(exception_ptr);
     } else {
       return true;
     }
@@ -122,19 +371,185 @@ bool ThreadPool::checkForException(bool rethrow) {
   return false;
 }
 
+void ThreadPool::setExceptionPolicy(ExceptionPolicy policy) {
+  std::lock_guard<std::mutex> lock {m_state_mutex};
+  m_exception_policy = policy;
+}
+
+std::vector<std::exception_ptr> ThreadPool::exceptions() const {
+  std::lock_guard<std::mutex> lock {m_state_mutex};
+  return m_exceptions;
+}
+
+void ThreadPool::clearExceptions() {
+  {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_exceptions.clear();
+    m_failed = false;
+  }
+  // Resume the processing of the queued tasks
+  m_task_available.notify_all();
+  m_helpers_wakeup.notify_all();
+}
+
+std::vector<ThreadPool::Task> ThreadPool::drainPending() {
+  std::vector<Task> drained;
+  for (auto& queue : m_queues) {
+    std::lock_guard<std::mutex> lock {queue->mutex};
+    for (auto& queued : queue->tasks) {
+      drained.emplace_back(std::move(queued.task));
+    }
+    m_queued_tasks -= queue->tasks.size();
+    queue->tasks.clear();
+  }
+
+  if (!drained.empty()) {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_unfinished_tasks -= drained.size();
+    m_workers_idle.notify_all();
+    m_space_available.notify_all();
+    m_helpers_wakeup.notify_all();
+  }
+  return drained;
+}
+
+std::size_t ThreadPool::discardPending() {
+  return drainPending().size();
+}
+
+void ThreadPool::setPlacement(Placement placement) {
+#ifdef __linux__
+  auto nodes = allowedCpusByNode();
+
+  if (placement == Placement::NONE) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto& node : nodes) {
+      for (auto cpu : node) {
+        CPU_SET(cpu, &cpu_set);
+      }
+    }
+    for (auto& worker : m_workers) {
+      setThreadAffinity(worker, cpu_set);
+    }
+    return;
+  }
+
+  std::vector<unsigned int> cpus;
+  if (placement == Placement::COMPACT) {
+    for (auto& node : nodes) {
+      cpus.insert(cpus.end(), node.begin(), node.end());
+    }
+  } else {
+    std::size_t max_node_size = 0;
+    for (auto& node : nodes) {
+      max_node_size = std::max(max_node_size, node.size());
+    }
+    for (std::size_t i = 0; i < max_node_size; ++i) {
+      for (auto& node : nodes) {
+        if (i < node.size()) {
+          cpus.push_back(node[i]);
+        }
+      }
+    }
+  }
+  setPlacement(cpus);
+#else
+  (void) placement;
+#endif
+}
+
+void ThreadPool::setPlacement(const std::vector<unsigned int>& cpus) {
+  if (cpus.empty()) {
+    throw Elements::Exception() << "The list of CPUs for the workers can not be empty";
+  }
+#ifdef __linux__
+  for (std::size_t i = 0; i < m_workers.size(); ++i) {
+    auto cpu = cpus[i % cpus.size()];
+    if (cpu >= CPU_SETSIZE) {
+      throw Elements::Exception() << "Invalid CPU " << cpu;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    setThreadAffinity(m_workers[i], cpu_set);
+  }
+#endif
+}
+
+int ThreadPool::currentWorkerIndex() {
+  return s_current_pool ? static_cast<int>(s_current_worker) : -1;
+}
+
+unsigned int ThreadPool::threadCount() const {
+  return static_cast<unsigned int>(m_workers.size());
+}
+
+void ThreadPool::enableMetrics(bool enable) {
+  if (enable) {
+    m_submitted_tasks = 0;
+    m_peak_queued_tasks = m_queued_tasks.load();
+    for (auto& worker_metrics : m_worker_metrics) {
+      worker_metrics->reset();
+    }
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_metrics_start = Clock::now();
+  }
+  m_metrics_enabled = enable;
+}
+
+auto ThreadPool::metrics() const -> Metrics {
+  Metrics result {};
+  result.submitted = m_submitted_tasks;
+  result.queue_length = m_queued_tasks;
+  result.peak_queue_length = m_peak_queued_tasks;
+  {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    result.elapsed = Clock::now() - m_metrics_start;
+  }
+
+  std::uint64_t queue_wait_ns = 0, run_ns = 0;
+  for (auto& worker_metrics : m_worker_metrics) {
+    result.completed += worker_metrics->completed;
+    result.failed += worker_metrics->failed;
+    queue_wait_ns += worker_metrics->queue_wait_ns;
+    run_ns += worker_metrics->run_ns;
+    for (std::size_t bin = 0; bin < DurationHistogram::BINS; ++bin) {
+      result.queue_wait.counts[bin] += worker_metrics->queue_wait_bins[bin];
+      result.run_time.counts[bin] += worker_metrics->run_bins[bin];
+    }
+    double busy_ratio = 0.;
+    if (m_metrics_enabled && result.elapsed.count() > 0) {
+      busy_ratio = static_cast<double>(worker_metrics->busy_ns) / result.elapsed.count();
+    }
+    result.busy_ratio.push_back(busy_ratio);
+  }
+  result.queue_wait.total = std::chrono::nanoseconds(queue_wait_ns);
+  result.run_time.total = std::chrono::nanoseconds(run_ns);
+  return result;
+}
+
 void ThreadPool::block() {
-  // Wait for the queue to be empty
-  bool queue_is_empty = false;
-  while (!queue_is_empty && m_exception_ptr == nullptr) {
-    std::unique_lock<std::mutex> lock {m_queue_mutex};
-    queue_is_empty = m_queue.empty();
-    lock.unlock();
-    if (!queue_is_empty) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(m_empty_queue_wait_time));
-    }
-  }
-  // Wait for the workers to finish the currently executing tasks
-  waitWorkers(m_worker_sleeping_flags, m_empty_queue_wait_time);
+  // Called from a task: run the queued tasks while waiting for the rest of the
+  // tasks, except those also waiting within block()
+  if (s_current_pool == this) {
+    ++m_blocking_workers;
+    wakeUpHelpers();
+    helpUntil([this]() {
+      return m_unfinished_tasks == m_blocking_workers || (m_failed && m_running_tasks == m_blocking_workers);
+    });
+    --m_blocking_workers;
+    checkForException(true);
+    return;
+  }
+
+  // Wait for all the tasks to be done, or, if a task failed, for the workers
+  // to finish the currently executing tasks
+  std::unique_lock<std::mutex> lock {m_state_mutex};
+  m_workers_idle.wait(lock, [this]() {
+    return m_unfinished_tasks == 0 || (m_failed && m_running_tasks == 0);
+  });
+  lock.unlock();
   // Check if any worker finished with an exception
   checkForException(true);
 }
@@ -143,14 +558,108 @@ void ThreadPool::block() {
 ThreadPool::~ThreadPool() {
   // Stop all the workers. They will stop right after they finish the task
   // they already run.
-  std::fill(m_worker_run_flags.begin(), m_worker_run_flags.end(), false);
+  {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_stop = true;
+  }
+  m_task_available.notify_all();
+  m_space_available.notify_all();
+  m_helpers_wakeup.notify_all();
   // Now wait until all the workers have finish any current tasks
-  waitWorkers(m_worker_done_flags, m_empty_queue_wait_time);
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::setQueueCapacity(std::size_t capacity) {
+  {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_queue_capacity = capacity;
+  }
+  m_space_available.notify_all();
+}
+
+bool ThreadPool::reserveQueueSlot(bool blocking) {
+  // Workers are never throttled, or the pool could deadlock
+  std::size_t capacity = m_queue_capacity;
+  if (capacity == 0 || s_current_pool == this) {
+    ++m_queued_tasks;
+    return true;
+  }
+
+  auto queued = m_queued_tasks.load();
+  while (true) {
+    if (queued < capacity) {
+      if (m_queued_tasks.compare_exchange_weak(queued, queued + 1)) {
+        return true;
+      }
+      continue;
+    }
+    if (!blocking) {
+      return false;
+    }
+    // The waiting counter is increased before checking the queue length, so
+    // the workers can not miss this producer
+    std::unique_lock<std::mutex> lock {m_state_mutex};
+    ++m_waiting_producers;
+    m_space_available.wait(lock, [this]() {
+      return m_stop || m_failed || m_queue_capacity == 0 || m_queued_tasks < m_queue_capacity;
+    });
+    --m_waiting_producers;
+    capacity = m_queue_capacity;
+    if (m_stop || m_failed || capacity == 0) {
+      // The queue will not be consumed, or it is not bounded anymore
+      ++m_queued_tasks;
+      return true;
+    }
+    queued = m_queued_tasks.load();
+  }
+}
+
+void ThreadPool::enqueue(Task task) {
+  TaskQueue* queue;
+  if (m_scheduling == Scheduling::FIFO) {
+    queue = m_queues.front().get();
+  } else if (s_current_pool == this) {
+    queue = m_queues[s_current_worker].get();
+  } else {
+    queue = m_queues[m_next_queue++ % m_queues.size()].get();
+  }
+
+  bool record_metrics = m_metrics_enabled.load(std::memory_order_relaxed);
+  ++m_unfinished_tasks;
+  {
+    std::lock_guard<std::mutex> lock {queue->mutex};
+    queue->tasks.emplace_back(QueuedTask{std::move(task), record_metrics ? Clock::now() : Clock::time_point{}});
+  }
+
+  if (record_metrics) {
+    ++m_submitted_tasks;
+    auto queued = m_queued_tasks.load();
+    auto peak = m_peak_queued_tasks.load(std::memory_order_relaxed);
+    while (queued > peak && !m_peak_queued_tasks.compare_exchange_weak(peak, queued)) {
+    }
+  }
+
+  // Only touch the shared mutex if there is someone to wake up
+  if (m_sleeping_workers > 0) {
+    std::lock_guard<std::mutex> lock {m_state_mutex};
+    m_task_available.notify_one();
+  }
+  wakeUpHelpers();
 }
 
 void ThreadPool::submit(Task task) {
-  std::lock_guard<std::mutex> lock {m_queue_mutex};
-  m_queue.emplace_back(std::move(task));
+  reserveQueueSlot(true);
+  enqueue(std::move(task));
+}
+
+bool ThreadPool::trySubmit(Task task) {
+  if (!reserveQueueSlot(false)) {
+    return false;
+  }
+  enqueue(std::move(task));
+  return true;
 }
 
 } // Euclid namespace
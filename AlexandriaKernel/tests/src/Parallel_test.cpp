@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file tests/src/Parallel_test.cpp
+ * @author nikoapos
+ */
+
+#include <vector>
+#include <numeric>
+#include <functional>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ElementsKernel/Exception.h"
+#include "AlexandriaKernel/Parallel.h"
+
+using namespace Euclid;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE (Parallel_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( parallelFor_test ) {
+
+  // Given
+  ThreadPool pool {4};
+  std::vector<int> values(1000, 0);
+
+  // When
+  parallelFor(pool, 10, values.size(), [&values](std::size_t i) { values[i] = i; });
+
+  // Then
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    BOOST_CHECK_EQUAL(values[i], i < 10 ? 0 : i);
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( autoGrainSize_cost_test ) {
+
+  // Given
+  ThreadPool pool {4};
+  ThreadPool single {1};
+
+  // Then
+  // Not enough work to split
+  BOOST_CHECK_EQUAL(autoGrainSize(pool, 100, 10), 100);
+  BOOST_CHECK_EQUAL(autoGrainSize(single, 100000, 1000), 100000);
+  // Each task gets at least the minimum cost
+  BOOST_CHECK_EQUAL(autoGrainSize(pool, 1000, 1000, 8000), 63);
+  BOOST_CHECK_EQUAL(autoGrainSize(pool, 1000, 100, 8000), 80);
+  // Costly indexes are processed one by one
+  BOOST_CHECK_EQUAL(autoGrainSize(pool, 16, 1 << 20), 1);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( parallelFor_exception_test ) {
+
+  // Given
+  ThreadPool pool {4};
+
+  // Then
+  BOOST_CHECK_THROW(parallelFor(pool, 0, 100, 1, [](std::size_t i) {
+    if (i == 42) {
+      throw Elements::Exception();
+    }
+  }), Elements::Exception);
+  // The pool is still usable
+  BOOST_CHECK(!pool.checkForException());
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( parallelReduce_test ) {
+
+  // Given
+  ThreadPool pool {4};
+  std::vector<double> values(10000);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = 1. / (i + 1.);
+  }
+  auto map = [&values](std::size_t i) { return values[i]; };
+
+  // When
+  auto sum = parallelReduce(pool, 0, values.size(), 100, 0., map, std::plus<double>());
+  auto empty = parallelReduce(pool, 0, 0, 0., map, std::plus<double>());
+
+  // Then
+  // Reduce the chunks sequentially, so the result must be bit-to-bit the same
+  double expected = 0.;
+  for (std::size_t chunk = 0; chunk < values.size(); chunk += 100) {
+    expected += std::accumulate(values.begin() + chunk, values.begin() + chunk + 100, 0.);
+  }
+  BOOST_CHECK_EQUAL(sum, expected);
+  BOOST_CHECK_EQUAL(empty, 0.);
+  // And independent of the number of threads
+  ThreadPool single {1};
+  BOOST_CHECK_EQUAL(parallelReduce(single, 0, values.size(), 100, 0., map, std::plus<double>()), expected);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( parallelTransform_test ) {
+
+  // Given
+  ThreadPool pool {4};
+  std::vector<int> input(1000);
+  std::iota(input.begin(), input.end(), 0);
+  std::vector<int> output(input.size());
+
+  // When
+  auto end = parallelTransform(pool, input.begin(), input.end(), output.begin(), [](int v) { return v * 2; });
+
+  // Then
+  BOOST_CHECK(end == output.end());
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    BOOST_CHECK_EQUAL(output[i], input[i] * 2);
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( nested_parallelFor_test ) {
+
+  // Given
+  ThreadPool pool {2, ThreadPool::Scheduling::WORK_STEALING};
+  std::vector<std::vector<int>> matrix(16, std::vector<int>(100));
+
+  // When
+  parallelFor(pool, 0, matrix.size(), 1, [&pool, &matrix](std::size_t row) {
+    parallelFor(pool, 0, matrix[row].size(), 10, [&matrix, row](std::size_t col) {
+      matrix[row][col] = static_cast<int>(row * col);
+    });
+  });
+
+  // Then
+  for (std::size_t row = 0; row < matrix.size(); ++row) {
+    for (std::size_t col = 0; col < matrix[row].size(); ++col) {
+      BOOST_CHECK_EQUAL(matrix[row][col], row * col);
+    }
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( defaultPool_test ) {
+
+  // Given
+  std::vector<int> input(1000);
+  std::iota(input.begin(), input.end(), 0);
+  std::vector<int> output(input.size());
+
+  // When
+  parallelTransform(input.begin(), input.end(), output.begin(), [](int v) { return v + 1; });
+  auto sum = parallelReduce(0, output.size(), 0l,
+                            [&output](std::size_t i) { return static_cast<long>(output[i]); },
+                            std::plus<long>());
+
+  // Then
+  BOOST_CHECK_EQUAL(&ThreadPool::defaultPool(), &ThreadPool::defaultPool());
+  BOOST_CHECK_EQUAL(sum, 1000 * 1001 / 2);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END ()
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file tests/src/Pipeline_test.cpp
+ * @author nikoapos
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ElementsKernel/Exception.h"
+#include "AlexandriaKernel/Pipeline.h"
+
+using namespace Euclid;
+
+namespace {
+
+/// Source generating the integers in [0, n)
+struct Counter {
+  int n;
+  int next;
+  bool operator()(int& item) {
+    if (next >= n) {
+      return false;
+    }
+    item = next++;
+    return true;
+  }
+};
+
+/// Sleeps a different amount of time depending on the value, so parallel
+/// stages finish their items out of order
+int slowSquare(int value) {
+  std::this_thread::sleep_for(std::chrono::microseconds((value % 7) * 50));
+  return value * value;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE (Pipeline_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( ordered_test ) {
+
+  // Given
+  Pipeline pipeline {4};
+  std::vector<std::string> output;
+
+  // When
+  auto numbers = pipeline.source<int>(Counter{200, 0});
+  auto squares = pipeline.stage(numbers, slowSquare, 4);
+  auto strings = pipeline.stage(squares, [](int v) { return std::to_string(v); }, 2);
+  pipeline.sink(strings, [&output](std::string s) { output.emplace_back(std::move(s)); });
+  pipeline.run();
+
+  // Then
+  BOOST_CHECK_EQUAL(output.size(), 200);
+  for (int i = 0; i < static_cast<int>(output.size()); ++i) {
+    BOOST_CHECK_EQUAL(output[i], std::to_string(i * i));
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( unordered_test ) {
+
+  // Given
+  Pipeline pipeline {4};
+  std::vector<int> output;
+
+  // When
+  auto numbers = pipeline.source<int>(Counter{200, 0});
+  auto squares = pipeline.stage(numbers, slowSquare, 4, Pipeline::Ordering::UNORDERED);
+  pipeline.sink(squares, [&output](int v) { output.push_back(v); });
+  pipeline.run();
+
+  // Then
+  std::sort(output.begin(), output.end());
+  BOOST_CHECK_EQUAL(output.size(), 200);
+  for (int i = 0; i < static_cast<int>(output.size()); ++i) {
+    BOOST_CHECK_EQUAL(output[i], i * i);
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( bounded_test ) {
+
+  // Given
+  Pipeline pipeline {2};
+  std::atomic<int> produced {0};
+  int max_in_flight = 0;
+
+  // When
+  auto numbers = pipeline.source<int>([&produced](int& item) {
+    item = produced;
+    return ++produced <= 100;
+  });
+  pipeline.sink(numbers, [&produced, &max_in_flight](int item) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    max_in_flight = std::max(max_in_flight, produced - item);
+  });
+  pipeline.run();
+
+  // Then
+  // The queue, the item being produced and the item being consumed
+  BOOST_CHECK_LE(max_in_flight, 4);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( exception_test ) {
+
+  // Given
+  Pipeline pipeline {2};
+  int consumed = 0;
+
+  // When
+  auto numbers = pipeline.source<int>(Counter{1000000, 0});
+  auto checked = pipeline.stage(numbers, [](int v) {
+    if (v == 50) {
+      throw Elements::Exception() << "Invalid value";
+    }
+    return v;
+  }, 2);
+  pipeline.sink(checked, [&consumed](int) { ++consumed; });
+
+  // Then
+  BOOST_CHECK_THROW(pipeline.run(), Elements::Exception);
+  BOOST_CHECK_LE(consumed, 50);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( cancel_test ) {
+
+  // Given
+  Pipeline pipeline {2};
+  int consumed = 0;
+
+  // When
+  auto numbers = pipeline.source<int>(Counter{1000000, 0});
+  pipeline.sink(numbers, [&pipeline, &consumed](int) {
+    if (++consumed == 10) {
+      pipeline.cancel();
+    }
+  });
+  pipeline.run();
+
+  // Then
+  BOOST_CHECK_EQUAL(consumed, 10);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( invalid_topology_test ) {
+
+  // Given
+  Pipeline unconsumed, consumed_twice;
+  auto numbers = consumed_twice.source<int>(Counter{10, 0});
+  unconsumed.source<int>(Counter{10, 0});
+
+  // When
+  consumed_twice.sink(numbers, [](int) {});
+
+  // Then
+  BOOST_CHECK_THROW(consumed_twice.sink(numbers, [](int) {}), Elements::Exception);
+  BOOST_CHECK_THROW(consumed_twice.stage(numbers, [](int v) { return v; }), Elements::Exception);
+  BOOST_CHECK_THROW(unconsumed.run(), Elements::Exception);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END ()
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file tests/src/TaskGroup_test.cpp
+ * @author nikoapos
+ */
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ElementsKernel/Exception.h"
+#include "AlexandriaKernel/TaskGroup.h"
+
+using namespace Euclid;
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE (TaskGroup_test)
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( wait_test ) {
+
+  // Given
+  std::atomic<int> fast_counter {0}, slow_counter {0};
+  ThreadPool pool {4};
+  TaskGroup fast {pool}, slow {pool};
+
+  // When
+  for (int i = 0; i < 2; ++i) {
+    slow.submit([&slow_counter]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      ++slow_counter;
+    });
+  }
+  for (int i = 0; i < 100; ++i) {
+    fast.submit([&fast_counter]() { ++fast_counter; });
+  }
+  fast.wait();
+
+  // Then
+  // Waiting for one group does not wait for the other
+  BOOST_CHECK_EQUAL(fast_counter, 100);
+  BOOST_CHECK_EQUAL(slow_counter, 0);
+  slow.wait();
+  BOOST_CHECK_EQUAL(slow_counter, 2);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( exception_test ) {
+
+  // Given
+  std::atomic<int> counter {0};
+  ThreadPool pool {4};
+  TaskGroup failing {pool}, healthy {pool};
+
+  // When
+  failing.submit([]() { throw Elements::Exception(); });
+  for (int i = 0; i < 100; ++i) {
+    healthy.submit([&counter]() { ++counter; });
+  }
+
+  // Then
+  BOOST_CHECK_THROW(failing.wait(), Elements::Exception);
+  BOOST_CHECK(failing.checkForException());
+  // The exception is not propagated to the pool nor to other groups
+  BOOST_CHECK_NO_THROW(healthy.wait());
+  BOOST_CHECK_EQUAL(counter, 100);
+  BOOST_CHECK(!pool.checkForException());
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( cancel_test ) {
+
+  // Given
+  std::atomic<int> started {0}, interrupted {0};
+  ThreadPool pool {2};
+  TaskGroup group {pool};
+  auto token = group.cancellationToken();
+
+  // When
+  for (int i = 0; i < 10; ++i) {
+    group.submit([&started, &interrupted, token]() {
+      ++started;
+      while (!token.isCancelled()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      ++interrupted;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  group.cancel();
+  group.wait();
+
+  // Then
+  // Only the tasks already running when cancelled are started
+  BOOST_CHECK_EQUAL(started, 2);
+  BOOST_CHECK_EQUAL(interrupted, 2);
+  BOOST_CHECK(!group.checkForException());
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( discarded_test ) {
+
+  // Given
+  std::atomic<int> counter {0};
+  ThreadPool pool {1};
+  TaskGroup group {pool};
+
+  // When
+  group.submit([]() { std::this_thread::sleep_for(std::chrono::milliseconds(100)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  for (int i = 0; i < 10; ++i) {
+    group.submit([&counter]() { ++counter; });
+  }
+  pool.discardPending();
+
+  // Then
+  // Discarded tasks must not leave the group waiting forever
+  group.wait();
+  BOOST_CHECK_EQUAL(counter, 0);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( nested_test ) {
+
+  // Given
+  // Less workers than outer tasks, so waiting on the inner groups would
+  // deadlock if the workers were just sleeping
+  ThreadPool pool {2};
+  std::atomic<int> counter {0};
+
+  // When
+  TaskGroup outer {pool};
+  for (int i = 0; i < 8; ++i) {
+    outer.submit([&pool, &counter]() {
+      TaskGroup inner {pool};
+      for (int j = 0; j < 10; ++j) {
+        inner.submit([&counter]() { ++counter; });
+      }
+      inner.wait();
+    });
+  }
+  outer.wait();
+
+  // Then
+  BOOST_CHECK_EQUAL(counter, 80);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE_END ()
@@ -26,6 +26,11 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <numeric>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 #include <boost/test/unit_test.hpp>
 
@@ -166,6 +171,364 @@ BOOST_AUTO_TEST_CASE( checkForException_test ) {
 
 }
 
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( short_tasks_latency_test ) {
+
+  // Given
+  std::atomic<int> counter {0};
+  ThreadPool pool {4};
+  
+  // When
+  // With a polling implementation each round trip would cost tens of milliseconds
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 100; ++i) {
+    pool.submit([&counter]() { ++counter; });
+    pool.block();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  
+  // Then
+  BOOST_CHECK_EQUAL(counter, 100);
+  BOOST_CHECK_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 1000);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( work_stealing_nested_test ) {
+
+  // Given
+  std::atomic<int> counter {0};
+  ThreadPool pool {4, ThreadPool::Scheduling::WORK_STEALING};
+  
+  // When
+  // Each top level task submits more tasks into its own worker deque, which
+  // must be stolen by the others and waited for by block()
+  for (int i = 0; i < 10; ++i) {
+    pool.submit([&pool, &counter]() {
+      for (int j = 0; j < 100; ++j) {
+        pool.submit([&counter]() { ++counter; });
+      }
+      ++counter;
+    });
+  }
+  pool.block();
+  
+  // Then
+  BOOST_CHECK(!pool.checkForException());
+  BOOST_CHECK_EQUAL(counter, 1010);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( work_stealing_exception_test ) {
+
+  // Given
+  ThreadPool pool {4, ThreadPool::Scheduling::WORK_STEALING};
+  
+  // When
+  pool.submit(ExceptionTask());
+  
+  // Then
+  BOOST_CHECK_THROW(pool.block(), Elements::Exception);
+  BOOST_CHECK(pool.checkForException());
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( future_test ) {
+
+  // Given
+  ThreadPool pool {4};
+  
+  // When
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < 10; ++i) {
+    futures.emplace_back(pool.submit([i]() { return i * i; }));
+  }
+  auto failed = pool.submit([]() -> int { throw Elements::Exception(); });
+  
+  // Then
+  for (int i = 0; i < 10; ++i) {
+    BOOST_CHECK_EQUAL(futures[i].get(), i * i);
+  }
+  BOOST_CHECK_THROW(failed.get(), Elements::Exception);
+  // The exception goes to the future, not to the pool
+  pool.block();
+  BOOST_CHECK(!pool.checkForException());
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( metrics_test ) {
+
+  // Given
+  std::mutex mutex;
+  std::vector<int> output {};
+  ThreadPool pool {2};
+  
+  // When
+  pool.enableMetrics();
+  for (int i = 0; i < 4; ++i) {
+    pool.submit(SleepTask(50, mutex, output));
+  }
+  pool.submit(ExceptionTask());
+  BOOST_CHECK_THROW(pool.block(), Elements::Exception);
+  auto metrics = pool.metrics();
+  
+  // Then
+  BOOST_CHECK_EQUAL(metrics.submitted, 5);
+  BOOST_CHECK_EQUAL(metrics.completed, 4);
+  BOOST_CHECK_EQUAL(metrics.failed, 1);
+  BOOST_CHECK_EQUAL(metrics.queue_length, 0);
+  BOOST_CHECK_GE(metrics.peak_queue_length, 3);
+  BOOST_CHECK_EQUAL(metrics.busy_ratio.size(), 2);
+  for (auto ratio : metrics.busy_ratio) {
+    BOOST_CHECK_GT(ratio, 0.);
+    BOOST_CHECK_LE(ratio, 1.);
+  }
+  auto run_count = std::accumulate(metrics.run_time.counts.begin(), metrics.run_time.counts.end(), 0u);
+  auto wait_count = std::accumulate(metrics.queue_wait.counts.begin(), metrics.queue_wait.counts.end(), 0u);
+  BOOST_CHECK_EQUAL(run_count, 5);
+  BOOST_CHECK_EQUAL(wait_count, 5);
+  BOOST_CHECK(metrics.run_time.total >= std::chrono::milliseconds(200));
+  // Sleeping 50 ms falls in the bin [2^15, 2^16) microseconds
+  BOOST_CHECK_EQUAL(metrics.run_time.counts[16], 4);
+  BOOST_CHECK(ThreadPool::DurationHistogram::upperEdge(16) == std::chrono::microseconds(65536));
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( bounded_queue_test ) {
+
+  // Given
+  std::mutex mutex;
+  std::vector<int> output {};
+  ThreadPool pool {1};
+  pool.setQueueCapacity(2);
+  pool.enableMetrics();
+  
+  // When
+  // The worker takes the first one, the next two fill the queue
+  pool.submit(SleepTask(200, mutex, output));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  BOOST_CHECK(pool.trySubmit(SleepTask(10, mutex, output)));
+  BOOST_CHECK(pool.trySubmit(SleepTask(10, mutex, output)));
+  BOOST_CHECK(!pool.trySubmit(SleepTask(10, mutex, output)));
+  // This one must wait until the first task is done
+  auto start = std::chrono::steady_clock::now();
+  pool.submit(SleepTask(10, mutex, output));
+  auto waited = std::chrono::steady_clock::now() - start;
+  pool.block();
+  
+  // Then
+  BOOST_CHECK(waited >= std::chrono::milliseconds(100));
+  BOOST_CHECK_EQUAL(output.size(), 4);
+  BOOST_CHECK_LE(pool.metrics().peak_queue_length, 2);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( bounded_queue_nested_test ) {
+
+  // Given
+  std::atomic<int> counter {0};
+  ThreadPool pool {2};
+  pool.setQueueCapacity(1);
+  
+  // When
+  // Workers are not throttled, so this must not deadlock
+  for (int i = 0; i < 4; ++i) {
+    pool.submit([&pool, &counter]() {
+      for (int j = 0; j < 10; ++j) {
+        pool.submit([&counter]() { ++counter; });
+      }
+    });
+  }
+  pool.block();
+  
+  // Then
+  BOOST_CHECK_EQUAL(counter, 40);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( collect_exceptions_test ) {
+
+  // Given
+  std::atomic<int> counter {0};
+  ThreadPool pool {4};
+  pool.setExceptionPolicy(ThreadPool::ExceptionPolicy::COLLECT);
+  
+  // When
+  for (int i = 0; i < 100; ++i) {
+    if (i % 10 == 0) {
+      pool.submit(ExceptionTask());
+    } else {
+      pool.submit([&counter]() { ++counter; });
+    }
+  }
+  
+  // Then
+  // All the tasks are run, and the first exception is rethrown
+  BOOST_CHECK_THROW(pool.block(), Elements::Exception);
+  BOOST_CHECK_EQUAL(counter, 90);
+  BOOST_CHECK_EQUAL(pool.exceptions().size(), 10);
+  pool.clearExceptions();
+  BOOST_CHECK(!pool.checkForException());
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( resume_after_exception_test ) {
+
+  // Given
+  std::mutex mutex;
+  std::vector<int> output {};
+  ThreadPool pool {1};
+  
+  // When
+  pool.submit(ExceptionTask());
+  pool.submit(SleepTask(10, mutex, output));
+  BOOST_CHECK_THROW(pool.block(), Elements::Exception);
+  
+  // Then
+  // The task after the failure has not been started, but it is still queued
+  BOOST_CHECK_EQUAL(output.size(), 0);
+  pool.clearExceptions();
+  pool.block();
+  BOOST_CHECK_EQUAL(output.size(), 1);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( discard_pending_test ) {
+
+  // Given
+  std::mutex mutex;
+  std::vector<int> output {};
+  ThreadPool pool {1};
+  
+  // When
+  pool.submit(SleepTask(200, mutex, output));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (int i = 0; i < 5; ++i) {
+    pool.submit(SleepTask(10, mutex, output));
+  }
+  auto drained = pool.drainPending();
+  pool.submit(SleepTask(20, mutex, output));
+  pool.submit(SleepTask(30, mutex, output));
+  auto discarded = pool.discardPending();
+  pool.block();
+  
+  // Then
+  BOOST_CHECK_EQUAL(drained.size(), 5);
+  BOOST_CHECK_EQUAL(discarded, 2);
+  BOOST_CHECK_EQUAL(output.size(), 1);
+  // Drained tasks can be resubmitted
+  for (auto& task : drained) {
+    pool.submit(std::move(task));
+  }
+  pool.block();
+  BOOST_CHECK_EQUAL(output.size(), 6);
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( worker_index_test ) {
+
+  // Given
+  std::mutex mutex;
+  std::vector<int> indexes;
+  ThreadPool pool {4};
+  
+  // When
+  for (int i = 0; i < 100; ++i) {
+    pool.submit([&mutex, &indexes]() {
+      std::lock_guard<std::mutex> lock {mutex};
+      indexes.push_back(ThreadPool::currentWorkerIndex());
+    });
+  }
+  pool.block();
+  
+  // Then
+  BOOST_CHECK_EQUAL(ThreadPool::currentWorkerIndex(), -1);
+  BOOST_CHECK_EQUAL(indexes.size(), 100);
+  for (auto index : indexes) {
+    BOOST_CHECK_GE(index, 0);
+    BOOST_CHECK_LT(index, 4);
+  }
+
+}
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( placement_test ) {
+
+  // Given
+  std::atomic<int> counter {0};
+  ThreadPool pool {4};
+  
+  // When
+  BOOST_CHECK_NO_THROW(pool.setPlacement(ThreadPool::Placement::COMPACT));
+  BOOST_CHECK_NO_THROW(pool.setPlacement(ThreadPool::Placement::SCATTER));
+  BOOST_CHECK_NO_THROW(pool.setPlacement(std::vector<unsigned int>{0}));
+  BOOST_CHECK_THROW(pool.setPlacement(std::vector<unsigned int>{}), Elements::Exception);
+  for (int i = 0; i < 100; ++i) {
+    pool.submit([&counter]() {
+#ifdef __linux__
+      if (sched_getcpu() != 0) {
+        throw Elements::Exception() << "Worker running on the wrong CPU";
+      }
+#endif
+      ++counter;
+    });
+  }
+  
+  // Then
+  BOOST_CHECK_NO_THROW(pool.block());
+  BOOST_CHECK_EQUAL(counter, 100);
+  BOOST_CHECK_NO_THROW(pool.setPlacement(ThreadPool::Placement::NONE));
+
+}
+
+
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE( block_from_task_test ) {
+
+  // Given
+  ThreadPool pool {2};
+  std::atomic<int> counter {0};
+
+  // When
+  for (int i = 0; i < 4; ++i) {
+    pool.submit([&pool, &counter]() {
+      for (int j = 0; j < 10; ++j) {
+        pool.submit([&counter]() { ++counter; });
+      }
+      // All the workers end up here, so they must keep processing the queue
+      pool.block();
+    });
+  }
+  pool.block();
+
+  // Then
+  BOOST_CHECK_EQUAL(counter, 40);
+  BOOST_CHECK_EQUAL(ThreadPool::currentPool(), static_cast<ThreadPool*>(nullptr));
+  BOOST_CHECK_THROW(pool.helpUntil([]() { return true; }), Elements::Exception);
+
+}
 
 //-----------------------------------------------------------------------------
 
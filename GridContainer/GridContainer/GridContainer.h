@@ -25,6 +25,7 @@
 #ifndef GRIDCONTAINER_GRIDCONTAINER_H
 #define GRIDCONTAINER_GRIDCONTAINER_H
 
+#include <array>
 #include <memory>
 #include <tuple>
 #include <iterator>
@@ -497,7 +498,13 @@ private:
   const GridContainer<GridCellManager, AxesTypes...>& m_owner;
   cell_manager_iter_type m_data_iter;
   std::map<size_t, size_t> m_fixed_indices;
+  /// When there are fixed axes, the iteration is a nested loop over the free ones, from the fastest
+  /// varying. Consecutive free axes are merged into a single level. m_loop_jumps holds how far the
+  /// data iterator moves when a level is incremented, after the faster levels wrap around.
+  std::array<size_t, sizeof...(AxesTypes)> m_loop_sizes {}, m_loop_counters {}, m_loop_jumps {};
+  size_t m_loop_levels = 0;
   void forwardToIndex(size_t axis, size_t fixed_index);
+  void updateLoops();
 
 }; // end of class iter
 
@@ -1079,6 +1079,45 @@ BOOST_FIXTURE_TEST_CASE(sliceFixAxisNonZeroIndexAccess, GridContainer_Fixture) {
 
 }
 
+//-----------------------------------------------------------------------------
+// Test that the slice iterators visit, in order, all the cells of the slice
+//-----------------------------------------------------------------------------
+
+BOOST_FIXTURE_TEST_CASE(sliceIteratorAllCells, GridContainer_Fixture) {
+
+  // Given
+  GridContainerType grid {axes_tuple};
+  double value = 0;
+  for (auto& cell : grid) {
+    cell = value++;
+  }
+
+  // When
+  std::vector<GridContainerType> slices;
+  slices.emplace_back(grid.fixAxisByIndex<0>(3));
+  slices.emplace_back(grid.fixAxisByIndex<2>(5));
+  slices.emplace_back(grid.fixAxisByIndex<3>(1));
+  slices.emplace_back(grid.fixAxisByIndex<0>(1).fixAxisByIndex<3>(1));
+  slices.emplace_back(grid.fixAxisByIndex<1>(2).fixAxisByIndex<2>(0));
+  slices.emplace_back(grid.fixAxisByIndex<0>(4).fixAxisByIndex<1>(0).fixAxisByIndex<2>(3).fixAxisByIndex<3>(1));
+  std::vector<size_t> expected_sizes {36, 30, 90, 18, 10, 1};
+
+  // Then
+  for (size_t i = 0; i < slices.size(); ++i) {
+    auto& slice = slices[i];
+    size_t count = 0;
+    double previous = -1;
+    for (auto iter = slice.begin(); iter != slice.end(); ++iter, ++count) {
+      BOOST_CHECK_GT(*iter, previous);
+      BOOST_CHECK_EQUAL(*iter, grid(iter.axisIndex<0>(), iter.axisIndex<1>(),
+                                    iter.axisIndex<2>(), iter.axisIndex<3>()));
+      previous = *iter;
+    }
+    BOOST_CHECK_EQUAL(count, expected_sizes[i]);
+  }
+
+}
+
 //-----------------------------------------------------------------------------
 
 BOOST_AUTO_TEST_SUITE_END ()
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file NdArray/AlignedBuffer.h
+ * @author Alejandro Alvarez Ayllon
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_ALIGNEDBUFFER_H
+#define ALEXANDRIA_NDARRAY_ALIGNEDBUFFER_H
+
+#include <cstddef>
+#include <vector>
+#include "NdArray/NdArray.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/**
+ * Storage for an NdArray with its first element aligned to a cache line, so it is also
+ * valid for aligned SIMD loads (up to AVX-512).
+ *
+ * Optionally, big buffers can request transparent huge pages to the kernel (via madvise). They
+ * are then aligned to the size of a huge page, so all the memory can be backed by them. This reduces
+ * the TLB misses on arrays of several GB. The request is only a hint: if the system does not support
+ * it, the buffer is still usable.
+ *
+ * It can be used as the Container of an NdArray:
+ * @code
+ * NdArray<float> array{shape, AlignedBuffer<float>(n_elements, true)};
+ * @endcode
+ * @tparam T
+ *  Element type. The elements are value-initialized, as with std::vector.
+ */
+template<typename T>
+class AlignedBuffer {
+public:
+  /// Alignment of the first element, in bytes
+  static constexpr size_t alignment = 64;
+
+  /// Size of a transparent huge page, in bytes
+  static constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+  /**
+   * Constructor
+   * @param size
+   *    Number of elements
+   * @param huge_pages
+   *    If true, and the buffer is at least hugePageSize bytes, use transparent huge pages
+   * @throws std::bad_alloc
+   *    If the memory can not be allocated
+   */
+  explicit AlignedBuffer(size_t size = 0, bool huge_pages = false);
+
+  /**
+   * Copy constructor. The copy has its own memory, allocated with the same options.
+   */
+  AlignedBuffer(const AlignedBuffer& other);
+
+  /**
+   * Move constructor
+   */
+  AlignedBuffer(AlignedBuffer&& other) noexcept;
+
+  /**
+   * Destructor
+   */
+  ~AlignedBuffer();
+
+  AlignedBuffer& operator=(AlignedBuffer other) noexcept;
+
+  /**
+   * @return Number of elements
+   */
+  size_t size() const {
+    return m_size;
+  }
+
+  /**
+   * @return Pointer to the first element. It is aligned to at least `alignment` bytes.
+   */
+  T *data() {
+    return m_data;
+  }
+
+  /**
+   * @copydoc data()
+   */
+  const T *data() const {
+    return m_data;
+  }
+
+  /**
+   * @return true if this buffer requests huge pages
+   */
+  bool hugePages() const {
+    return m_huge_pages;
+  }
+
+  /**
+   * @return Number of elements that fit in the allocated memory
+   */
+  size_t capacity() const {
+    return m_capacity;
+  }
+
+  /**
+   * Change the number of elements. The existing ones are kept and the new ones are value-initialized.
+   * The memory is only reallocated if the size is bigger than the capacity.
+   * @throws std::bad_alloc
+   *    If the memory can not be allocated
+   */
+  void resize(size_t size);
+
+  /**
+   * Make sure there is memory for at least n elements, so resizing up to n does not reallocate
+   * @throws std::bad_alloc
+   *    If the memory can not be allocated
+   */
+  void reserve(size_t n);
+
+  /**
+   * Release the memory not used by the elements
+   */
+  void shrink_to_fit();
+
+private:
+  T *m_data;
+  size_t m_size, m_capacity;
+  bool m_huge_pages;
+
+  /// Moves the elements to a new allocation with the given capacity
+  void reallocate(size_t capacity);
+
+  /// Allocates memory for n elements, without initializing it
+  T *allocate(size_t n) const;
+
+  /// Destroys the elements and releases the memory
+  void release();
+};
+
+/**
+ * Create an NdArray stored in an AlignedBuffer
+ * @param shape
+ *    Shape of the array
+ * @param huge_pages
+ *    If true, request huge pages for big arrays
+ */
+template<typename T>
+NdArray<T> createAligned(const std::vector<size_t>& shape, bool huge_pages = false);
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#include "NdArray/_impl/AlignedBuffer.icpp"
+
+#endif // ALEXANDRIA_NDARRAY_ALIGNEDBUFFER_H
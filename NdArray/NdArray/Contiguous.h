@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file NdArray/Contiguous.h
+ * @author Alejandro Alvarez Ayllon
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_CONTIGUOUS_H
+#define ALEXANDRIA_NDARRAY_CONTIGUOUS_H
+
+#include "AlexandriaKernel/ThreadPool.h"
+#include "NdArray/NdArray.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/**
+ * Get an array with the same shape and values, and its elements in row-major order in memory.
+ * If the array is a view whose memory is not contiguous (i.e. a transposition, or a Fortran ordered file),
+ * the values are copied into a new array. The copy is done in tiles that fit in the cache, so neither the reads
+ * nor the writes jump through the memory, and big arrays are split between the workers of the pool.
+ * @param array
+ *  Input array
+ * @param pool
+ *  Pool used for copying big arrays
+ * @return
+ *  The same array, sharing the memory, if it is already contiguous. A new array otherwise.
+ */
+template<typename T>
+NdArray<T> asContiguous(const NdArray<T>& array, ThreadPool& pool = ThreadPool::defaultPool());
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#include "NdArray/_impl/Contiguous.icpp"
+
+#endif // ALEXANDRIA_NDARRAY_CONTIGUOUS_H
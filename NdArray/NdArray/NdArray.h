@@ -26,17 +26,57 @@
 #define ALEXANDRIA_NDARRAY_H
 
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <stdexcept>
 #include <vector>
 #include <cassert>
 #include "AlexandriaKernel/memory_tools.h"
+#include "NdArray/Span.h"
 
 namespace Euclid {
 namespace NdArray {
 
+template<typename E>
+class Expression;
+
+namespace Operations_Impl {
+template<typename T>
+class ArrayTerminal;
+}
+
+namespace Reductions_Impl {
+template<typename T>
+struct Layout;
+}
+
+/**
+ * Range of indexes start, start + step, start + 2 * step... up to stop (excluded) along an axis,
+ * as in the start:stop:step notation of Python. stop is clamped to the size of the axis.
+ */
+struct Slice {
+  static constexpr size_t END = std::numeric_limits<size_t>::max();
+
+  Slice(size_t start = 0, size_t stop = END, size_t step = 1) : start(start), stop(stop), step(step) {}
+
+  size_t start, stop, step;
+};
+
 /**
- * Stores a multidimensional array in a contiguous piece of memory in row-major order
+ * Attribute of a structured NdArray, resolved once with NdArray::attribute(). Accessing
+ * the elements with a handle does not need to look up the attribute name.
+ */
+struct AttributeHandle {
+  explicit AttributeHandle(size_t index) : index(index) {}
+
+  /// Position of the attribute along the last axis
+  size_t index;
+};
+
+/**
+ * Stores a multidimensional array in a contiguous piece of memory in row-major order.
+ * Slicing, transposing or squeezing an NdArray creates a view: a new NdArray sharing the
+ * same memory, with its own shape, strides and offset, so no element is copied.
  * @tparam T
  *  Data type
  * @tparam Container
@@ -63,9 +103,24 @@ public:
     : public std::iterator<std::random_access_iterator_tag, typename std::conditional<Const, const T, T>::type> {
   private:
     ContainerInterface *m_container_ptr;
+    /// Layout of the array. The shape and strides are only kept for views that are not contiguous,
+    /// so the iterator does not depend on the lifetime of the NdArray, only on its container
+    std::vector<size_t> m_shape, m_strides;
+    size_t m_base_offset, m_size;
+    /// Position of the iterator, in row-major order
+    size_t m_pos;
+    /// Offset of the pointed element within the container
     size_t m_offset;
+    /// Position along the last axis
+    size_t m_row_pos;
+
+    Iterator(const NdArray& array, size_t pos);
+
+    /// Offset within the container of the element at the given position
+    size_t unravel_offset(size_t pos) const;
 
-    Iterator(ContainerInterface *container_ptr, size_t offset);
+    /// Recompute the offset after a jump
+    void seek();
 
     friend class NdArray;
 
@@ -245,6 +300,14 @@ public:
   template<typename ...Args>
   NdArray(const std::vector<size_t>& shape, const std::vector<std::string>& attr_names, Args&& ... args);
 
+  /**
+   * Constructs a matrix evaluating an element-wise expression (see NdArray/Operations.h)
+   * @param expression
+   *    The expression. Its values are converted to T.
+   */
+  template<typename E>
+  NdArray(const Expression<E>& expression);
+
   /**
    * Constructs a default-initialized matrix with the given shape (as an initializer list).
    * @param shape
@@ -355,6 +418,23 @@ public:
    */
   const T& at(const std::vector<size_t>& coords, const std::string& attr) const;
 
+  /**
+   * Gets a reference to the value stored at the given coordinates.
+   * @param coords
+   *    Elements coordinates, except last one
+   * @param attr
+   *    Attribute handle used to determine the last coordinate
+   * @throws std::out_of_range
+   *    If the number of coordinates is invalid, or any of them is out of bounds.
+   */
+  T& at(const std::vector<size_t>& coords, AttributeHandle attr);
+
+  /**
+   * Gets a constant reference to the value stored at the given coordinates.
+   * @copydetails at(const std::vector<size_t>&, AttributeHandle)
+   */
+  const T& at(const std::vector<size_t>& coords, AttributeHandle attr) const;
+
   /**
    * Gets a reference to the value stored at the given coordinates.
    * @param coords
@@ -364,6 +444,8 @@ public:
    * @note
    *    This is a convenience function that allows access without requiring a vector when the
    *    number of dimensions is known in advance (i.e. `at(x, y, z)` instead of `at(std::vector<size_t>{x, y, z})`).
+   *    The offset is computed directly from the arguments, without any allocation or virtual call,
+   *    so this is the preferred way of accessing single elements within loops.
    */
   template<typename ...D>
   T& at(size_t i, D... rest);
@@ -406,10 +488,52 @@ public:
   const_iterator end() const;
 
   /**
-   * Size of the underlying container
+   * Number of elements in the array (or view)
    */
   size_t size() const;
 
+  /**
+   * Distance, in number of elements, between two consecutive positions along each axis
+   */
+  const std::vector<size_t>& strides() const {
+    return m_stride_size;
+  }
+
+  /**
+   * @return true if the elements are consecutive in memory in row-major order, so they can be
+   *    accessed with data() or span(). This is always the case for an array that is not a view,
+   *    and for views that only slice the first axis.
+   */
+  bool isContiguous() const {
+    return m_contiguous;
+  }
+
+  /**
+   * Pointer to the first element, for passing the memory to external libraries or optimized loops.
+   * The pointer is invalidated by any operation that modifies the shape of the underlying array
+   * (i.e. concatenate).
+   * @throws std::invalid_argument
+   *    If the array is not contiguous
+   */
+  T *data();
+
+  /**
+   * @copydoc data()
+   */
+  const T *data() const;
+
+  /**
+   * Same as data(), but bundled with the number of elements
+   * @throws std::invalid_argument
+   *    If the array is not contiguous
+   */
+  Span<T> span();
+
+  /**
+   * @copydoc span()
+   */
+  Span<const T> span() const;
+
   /**
    * Two NdArrays are equal if their shapes and their content are equal
    */
@@ -420,22 +544,178 @@ public:
    */
   bool operator!=(const self_type& b) const;
 
+  /**
+   * Element-wise in-place addition of an NdArray, an expression or a scalar, which
+   * is broadcast to the shape of this array (see NdArray/Operations.h)
+   * @throws std::length_error
+   *    If other can not be broadcast to the shape of this array
+   * @note
+   *    If other reads this same data with a different layout (i.e. a += a.transpose()), it is
+   *    evaluated into a temporary first, so the result is as if there was no overlap.
+   */
+  template<typename Other>
+  self_type& operator+=(const Other& other);
+
+  /**
+   * Element-wise in-place subtraction
+   * @copydetails operator+=
+   */
+  template<typename Other>
+  self_type& operator-=(const Other& other);
+
+  /**
+   * Element-wise in-place multiplication
+   * @copydetails operator+=
+   */
+  template<typename Other>
+  self_type& operator*=(const Other& other);
+
+  /**
+   * Element-wise in-place division
+   * @copydetails operator+=
+   */
+  template<typename Other>
+  self_type& operator/=(const Other& other);
+
   /**
    * Concatenate to this array another one *along the first axis*
    * @return *this
+   * @throws std::invalid_argument
+   *    If this is a view on part of the data
    */
   self_type& concatenate(const self_type &other);
 
+  /**
+   * Concatenate to this array another one along the first axis, growing the storage geometrically.
+   * Appending repeatedly has then an amortized linear cost, instead of the quadratic cost of concatenate
+   * when the storage has to be reallocated on each call.
+   * @param other
+   *    An array with the same dimensionality, or a single entry with one dimension less
+   * @return *this
+   * @throws std::length_error
+   *    If the shapes do not match
+   * @throws std::invalid_argument
+   *    If this is a view on part of the data
+   */
+  self_type& append(const self_type& other);
+
+  /**
+   * @return The number of entries along the first axis that fit in the storage without
+   *    reallocating it. For views, and storages without capacity management, this is the size of the first axis.
+   */
+  size_t capacity() const;
+
+  /**
+   * Make sure the storage can hold n entries along the first axis, so concatenate and append do not
+   * reallocate it until that size is reached.
+   * @return *this
+   * @throws std::invalid_argument
+   *    If this is a view on part of the data
+   */
+  self_type& reserve(size_t n);
+
+  /**
+   * Release the storage reserved beyond the current size, if the container supports it
+   * @return *this
+   * @throws std::invalid_argument
+   *    If this is a view on part of the data
+   */
+  self_type& shrinkToFit();
+
+  /**
+   * Creates a view with the given range of indexes along an axis
+   * @param axis
+   *    Axis to slice
+   * @param range
+   *    Indexes to keep. If the axis is the last one, the attribute names are sliced too.
+   * @throws std::out_of_range
+   *    If the axis does not exist, or the start is beyond the end of the axis
+   * @throws std::invalid_argument
+   *    If the step is 0
+   * @note
+   *    The view shares the data with this array, as copies of an NdArray do
+   */
+  self_type slice(size_t axis, const Slice& range) const;
+
+  /**
+   * Creates a view with a range of indexes for each of the leading axes. The axes
+   * without a range are kept whole.
+   * @throws std::out_of_range
+   *    If there are more ranges than axes, or any of them is out of bounds
+   */
+  self_type slice(const std::vector<Slice>& ranges) const;
+
+  /**
+   * Creates a view fixing the index of an axis, so the view has one dimension less
+   * (i.e. select(1, j) is the j-th column of a matrix)
+   * @throws std::out_of_range
+   *    If the axis does not exist, or the index is out of bounds
+   */
+  self_type select(size_t axis, size_t index) const;
+
+  /**
+   * Creates a view with the axes in reverse order
+   * @throws std::invalid_argument
+   *    If the array has attribute names
+   */
+  self_type transpose() const;
+
+  /**
+   * Creates a view with the axes permuted
+   * @param axes
+   *    The i-th axis of the view corresponds to the axis axes[i] of this array
+   * @throws std::invalid_argument
+   *    If axes is not a permutation of the axes, or it moves the last axis of an array with attribute names
+   */
+  self_type transpose(const std::vector<size_t>& axes) const;
+
+  /**
+   * Creates a view without the axes of size 1. The attribute names are dropped
+   * if the last axis is removed.
+   */
+  self_type squeeze() const;
+
   /**
    * @return
    *    Attribute names
    */
   const std::vector<std::string>& attributes() const;
 
+  /**
+   * Resolves an attribute name, so it can be used for accessing the elements without
+   * searching for it every time. i.e.
+   * @code
+   * auto x = array.attribute("X");
+   * for (size_t i = 0; i < array.shape()[0]; ++i)
+   *   total += array.at(i, x);
+   * @endcode
+   * @throws std::out_of_range
+   *    If the attribute does not exist
+   */
+  AttributeHandle attribute(const std::string& name) const;
+
+  /**
+   * Creates a view with the values of one attribute, so it has one dimension less.
+   * Its elements are separated by the number of attributes, and it can be used as any other
+   * NdArray (i.e. in element-wise operations or reductions).
+   * @throws std::out_of_range
+   *    If the attribute does not exist
+   */
+  self_type field(const std::string& name) const;
+
+  /**
+   * @copydoc field(const std::string&) const
+   */
+  self_type field(AttributeHandle attr) const;
+
 private:
   std::vector<size_t> m_shape, m_stride_size;
   std::vector<std::string> m_attr_names;
   size_t m_size;
+  /// Offset of the first element within the container, for views
+  size_t m_offset = 0;
+  /// True if the elements are consecutive in memory, in row-major order
+  bool m_contiguous = true;
 
   struct ContainerInterface {
     /// Owned by the specific implementation ContainerWrapper,
@@ -460,6 +740,15 @@ private:
     /// Resize container
     virtual void resize(const std::vector<size_t>& shape) = 0;
 
+    /// @copydoc std::vector::capacity
+    virtual size_t capacity() const = 0;
+
+    /// @copydoc std::vector::reserve
+    virtual void reserve(size_t n) = 0;
+
+    /// @copydoc std::vector::shrink_to_fit
+    virtual void shrinkToFit() = 0;
+
     /// Expected to generate a deep copy of the underlying data
     virtual std::unique_ptr<ContainerInterface> copy() const = 0;
   };
@@ -509,6 +798,53 @@ private:
       m_data_ptr = m_container.data();
     }
 
+    template<typename T2>
+    auto capacityImpl(int) const -> decltype(std::declval<const Container<T2>>().capacity()) {
+      return m_container.capacity();
+    }
+
+    template<typename T2>
+    size_t capacityImpl(long) const {
+      return m_container.size();
+    }
+
+    template<typename T2>
+    auto reserveImpl(size_t n, int) -> decltype((void) std::declval<Container<T2>>().reserve(n), void()) {
+      m_container.reserve(n);
+    }
+
+    template<typename T2>
+    void reserveImpl(size_t, long) {
+    }
+
+    template<typename T2>
+    auto shrinkImpl(int) -> decltype((void) std::declval<Container<T2>>().shrink_to_fit(), void()) {
+      m_container.shrink_to_fit();
+    }
+
+    template<typename T2>
+    void shrinkImpl(long) {
+    }
+
+    /**
+     * @note
+     *  capacity, reserve and shrinkToFit delegate to the corresponding methods of the container
+     *  if it has them. Otherwise, the capacity is the size, and reserve does nothing.
+     */
+    size_t capacity() const final {
+      return capacityImpl<T>(0);
+    }
+
+    void reserve(size_t n) final {
+      reserveImpl<T>(n, 0);
+      m_data_ptr = m_container.data();
+    }
+
+    void shrinkToFit() final {
+      shrinkImpl<T>(0);
+      m_data_ptr = m_container.data();
+    }
+
     std::unique_ptr<ContainerInterface> copy() const final {
       return Euclid::make_unique<ContainerWrapper>(m_container);
     }
@@ -533,7 +869,14 @@ private:
    * @throws std::out_of_range
    *    If the number of coordinates is invalid, or any of them is out of bounds, or the attribute does not exist.
    */
-  size_t get_offset(std::vector<size_t> coords, const std::string& attr) const;
+  size_t get_offset(const std::vector<size_t>& coords, const std::string& attr) const;
+
+  /**
+   * Gets the total offset for the given coordinates, followed by last
+   * @throws std::out_of_range
+   *    If the number of coordinates is invalid, or any of them is out of bounds.
+   */
+  size_t get_offset(const std::vector<size_t>& coords, size_t last) const;
 
   /**
    * Compute the stride size for each dimension
@@ -541,31 +884,74 @@ private:
   void update_strides();
 
   /**
-   * Helper to expand at with a variable number of arguments
+   * @return true if this array only sees part of its container, or in a different order
    */
-  template<typename ...D>
-  T& at_helper(std::vector<size_t>& acc, size_t i, D... rest);
+  bool is_view() const;
 
   /**
-   * Helper to expand at with a variable number of arguments (base case)
+   * Verify other can be concatenated to this array
+   * @throws std::length_error
+   *    If the shapes do not match
+   * @throws std::invalid_argument
+   *    If this is a view
    */
-  T& at_helper(std::vector<size_t>& acc);
+  void check_concatenate(const self_type& other) const;
 
   /**
-   * Helper to expand at with a variable number of arguments, being the last an attribute name
+   * Recompute the size and the contiguity after modifying the shape or strides of a view
    */
-  T& at_helper(std::vector<size_t>& acc, const std::string& attr);
+  void update_view();
+
+  /**
+   * Offset within the container of the element at the given position, in row-major order
+   */
+  size_t unravel_offset(size_t pos) const;
+
+  /**
+   * Evaluates the expression into this array. If the expression reads the memory of this array
+   * with a different layout, it is evaluated into a temporary first.
+   * @throws std::length_error
+   *    If the expression can not be broadcast to the shape of this array
+   */
+  template<typename E>
+  void assign(E expression);
+
+  template<typename>
+  friend class Operations_Impl::ArrayTerminal;
+
+  template<typename>
+  friend struct Reductions_Impl::Layout;
 
   /**
-   * Helper to expand constant at with a variable number of arguments
+   * Helper to compute the offset for a variable number of arguments. It accumulates
+   * the offset of the axes already visited, so no intermediate container is needed.
+   * @param axis
+   *    Axis corresponding to i
+   * @param offset
+   *    Offset accumulated for the previous axes
    */
   template<typename ...D>
-  const T& at_helper(std::vector<size_t>& acc, size_t i, D... rest) const;
+  size_t offset_helper(size_t axis, size_t offset, size_t i, D... rest) const;
+
+  /**
+   * Helper to compute the offset for a variable number of arguments (base case)
+   */
+  size_t offset_helper(size_t axis, size_t offset) const;
 
   /**
-   * Helper to expand constant at with a variable number of arguments (base case)
+   * Helper to compute the offset for a variable number of arguments, being the last an attribute name
    */
-  const T& at_helper(std::vector<size_t>& acc) const;
+  size_t offset_helper(size_t axis, size_t offset, const std::string& attr) const;
+
+  /**
+   * Helper to compute the offset for a variable number of arguments, being the last an attribute handle
+   */
+  size_t offset_helper(size_t axis, size_t offset, AttributeHandle attr) const;
+
+  /**
+   * Throws std::out_of_range reporting an invalid number of coordinates
+   */
+  [[noreturn]] void throw_invalid_ncoords(size_t ncoords) const;
 
   template<typename ...D>
   self_type& reshape_helper(std::vector<size_t>& acc, size_t i, D... rest);
@@ -586,4 +972,6 @@ std::ostream& operator<<(std::ostream& out, const NdArray<T>& ndarray);
 #include "NdArray/_impl/NdArray.icpp"
 #undef NDARRAY_IMPL
 
+#include "NdArray/Operations.h"
+
 #endif // ALEXANDRIA_NDARRAY_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file NdArray/Operations.h
+ * @author Alejandro Alvarez Ayllon
+ *
+ * Element-wise operations over NdArrays.
+ *
+ * The operators and functions declared here do not compute anything: they return a lightweight
+ * expression that refers to the operands. The expression is evaluated when it is assigned to an
+ * NdArray, in a single pass over the elements and without intermediate arrays. i.e.
+ *
+ * @code
+ * NdArray<float> c = a * 2 + sqrt(b);
+ * @endcode
+ *
+ * Operands are broadcast as in numpy: the shapes are aligned on the last axis, and an axis of size 1
+ * (or a missing axis) is repeated to match the other operand. Scalars can be mixed with arrays, and they
+ * are converted to the value type of the other operand, so `float_array * 2.5` is still a float expression.
+ * The exception is a floating point scalar combined with an integral operand: the expression is promoted
+ * as in C++, so `int_array * 2.5` is a double expression.
+ *
+ * When all the operands are contiguous and have the same shape, the evaluation is a plain loop over
+ * the elements, which the compiler can vectorize.
+ *
+ * @note
+ *  operator== and operator!= keep comparing whole arrays. The element-wise versions are equal() and
+ *  notEqual(). The comparisons return boolean expressions, which can be assigned to an integral NdArray
+ *  or used as the condition of where().
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_OPERATIONS_H
+#define ALEXANDRIA_NDARRAY_OPERATIONS_H
+
+#include <vector>
+#include "NdArray/NdArray.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/**
+ * Base class of the element-wise expressions, using CRTP
+ * @tparam E
+ *  The concrete expression type
+ */
+template<typename E>
+class Expression {
+public:
+  /**
+   * @return The concrete expression
+   */
+  const E& derived() const {
+    return static_cast<const E&>(*this);
+  }
+};
+
+namespace Operations_Impl {
+
+struct Plus;
+struct Minus;
+struct Multiplies;
+struct Divides;
+struct Less;
+struct LessEqual;
+struct Greater;
+struct GreaterEqual;
+struct EqualTo;
+struct NotEqualTo;
+struct Negate;
+struct Abs;
+struct Sqrt;
+struct Exp;
+struct Log;
+struct Log10;
+struct Sin;
+struct Cos;
+struct Tan;
+struct Pow;
+
+/// Type of the expression returned by a binary operation, if A and B are valid operands
+template<typename Op, typename A, typename B, typename Enable = void>
+struct BinaryResult;
+
+/// Type of the expression returned by a unary operation, if A is an array or an expression
+template<typename Op, typename A, typename Enable = void>
+struct UnaryResult;
+
+/// Type of the expression returned by where()
+template<typename C, typename A, typename B, typename Enable = void>
+struct WhereResult;
+
+} // end of namespace Operations_Impl
+
+/// Element-wise addition
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::Plus, A, B>::type operator+(const A& a, const B& b);
+
+/// Element-wise subtraction
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::Minus, A, B>::type operator-(const A& a, const B& b);
+
+/// Element-wise multiplication
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::Multiplies, A, B>::type operator*(const A& a, const B& b);
+
+/// Element-wise division
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::Divides, A, B>::type operator/(const A& a, const B& b);
+
+/// Element-wise a < b
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::Less, A, B>::type operator<(const A& a, const B& b);
+
+/// Element-wise a <= b
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::LessEqual, A, B>::type operator<=(const A& a, const B& b);
+
+/// Element-wise a > b
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::Greater, A, B>::type operator>(const A& a, const B& b);
+
+/// Element-wise a >= b
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::GreaterEqual, A, B>::type operator>=(const A& a, const B& b);
+
+/// Element-wise a == b
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::EqualTo, A, B>::type equal(const A& a, const B& b);
+
+/// Element-wise a != b
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::NotEqualTo, A, B>::type notEqual(const A& a, const B& b);
+
+/// Element-wise power
+template<typename A, typename B>
+typename Operations_Impl::BinaryResult<Operations_Impl::Pow, A, B>::type pow(const A& a, const B& b);
+
+/// Element-wise negation
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Negate, A>::type operator-(const A& a);
+
+/// Element-wise absolute value
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Abs, A>::type abs(const A& a);
+
+/// Element-wise square root
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Sqrt, A>::type sqrt(const A& a);
+
+/// Element-wise exponential
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Exp, A>::type exp(const A& a);
+
+/// Element-wise natural logarithm
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Log, A>::type log(const A& a);
+
+/// Element-wise base 10 logarithm
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Log10, A>::type log10(const A& a);
+
+/// Element-wise sine
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Sin, A>::type sin(const A& a);
+
+/// Element-wise cosine
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Cos, A>::type cos(const A& a);
+
+/// Element-wise tangent
+template<typename A>
+typename Operations_Impl::UnaryResult<Operations_Impl::Tan, A>::type tan(const A& a);
+
+/**
+ * Element-wise selection: a where the condition is true, b otherwise
+ * @param condition
+ *  Array or expression, converted to bool
+ */
+template<typename C, typename A, typename B>
+typename Operations_Impl::WhereResult<C, A, B>::type where(const C& condition, const A& a, const B& b);
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#include "NdArray/_impl/Operations.icpp"
+
+#endif // ALEXANDRIA_NDARRAY_OPERATIONS_H
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file NdArray/RecordArray.h
+ * @author Alejandro Alvarez Ayllon
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_RECORDARRAY_H
+#define ALEXANDRIA_NDARRAY_RECORDARRAY_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "NdArray/NdArray.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/**
+ * Array of records whose fields can have different types, like numpy structured arrays.
+ *
+ * Each field is stored as its own NdArray (a column), with the shape of the record array.
+ * The columns are shared, not copied: field() returns an NdArray that refers to the same memory,
+ * so it can be modified in place, and addField does not copy the array it receives.
+ * @code
+ * RecordArray records({100});
+ * records.addField("ID", NdArray<int64_t>({100}));
+ * records.addField("FLUX", NdArray<float>({100}));
+ * auto flux = records.field<float>("FLUX");
+ * @endcode
+ */
+class RecordArray {
+public:
+  /**
+   * Constructor
+   * @param shape
+   *  Shape shared by all the fields
+   */
+  explicit RecordArray(const std::vector<size_t>& shape);
+
+  /**
+   * @return The shape of the array
+   */
+  const std::vector<size_t>& shape() const {
+    return m_shape;
+  }
+
+  /**
+   * @return The number of records
+   */
+  size_t size() const;
+
+  /**
+   * @return The names of the fields, in the order they were added
+   */
+  const std::vector<std::string>& fields() const {
+    return m_names;
+  }
+
+  /**
+   * @return true if there is a field with the given name
+   */
+  bool hasField(const std::string& name) const;
+
+  /**
+   * @return The type of the values of the field
+   * @throws std::out_of_range
+   *  If there is no such field
+   */
+  const std::type_info& fieldType(const std::string& name) const;
+
+  /**
+   * Add a field. The column is shared, not copied.
+   * @param name
+   *  Name of the field
+   * @param column
+   *  Values of the field. It can be a view.
+   * @throws std::invalid_argument
+   *  If the shape of the column does not match the shape of the array, or there is already a field with
+   *  that name
+   */
+  template<typename T>
+  void addField(const std::string& name, const NdArray<T>& column);
+
+  /**
+   * Get the values of a field, without copying them
+   * @tparam T
+   *  Type of the values. It must be the type of the field.
+   * @throws std::out_of_range
+   *  If there is no such field
+   * @throws std::invalid_argument
+   *  If the field does not have the type T
+   */
+  template<typename T>
+  NdArray<T> field(const std::string& name) const;
+
+private:
+  struct Column {
+    const std::type_info *type;
+    /// NdArray of the type of the field
+    std::shared_ptr<void> array;
+  };
+
+  std::vector<size_t> m_shape;
+  std::vector<std::string> m_names;
+  std::map<std::string, Column> m_columns;
+
+  const Column& get_column(const std::string& name) const;
+};
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#include "NdArray/_impl/RecordArray.icpp"
+
+#endif // ALEXANDRIA_NDARRAY_RECORDARRAY_H
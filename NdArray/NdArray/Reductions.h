@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file NdArray/Reductions.h
+ * @author Alejandro Alvarez Ayllon
+ *
+ * Reductions over a whole NdArray, or along one of its axes.
+ *
+ * The reductions along an axis return a new NdArray with the shape of the input without
+ * that axis. They choose between two kernels depending on the memory layout:
+ *  - If the elements along the axis are close in memory (i.e. the last axis of a contiguous array),
+ *    each output element is reduced independently.
+ *  - Otherwise, whole slices are accumulated into the output, so the input is still read in memory order.
+ *
+ * Sums use pairwise summation, so the rounding error grows with the logarithm of the number of
+ * elements instead of linearly. The result does not depend on the number of threads.
+ *
+ * min and max ignore NaN values, unless all of them are NaN.
+ *
+ * Inputs with at least `parallelThreshold` elements are split between the workers of the pool,
+ * which by default is ThreadPool::defaultPool().
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_REDUCTIONS_H
+#define ALEXANDRIA_NDARRAY_REDUCTIONS_H
+
+#include <limits>
+#include <type_traits>
+#include "AlexandriaKernel/ThreadPool.h"
+#include "NdArray/NdArray.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/// Inputs smaller than this number of elements are reduced in the calling thread
+constexpr size_t parallelThreshold = 1 << 16;
+
+/// Type used for the mean and norms: T if it is a floating point type, double otherwise
+template<typename T>
+using FloatingType = typename std::conditional<std::is_floating_point<T>::value, T, double>::type;
+
+/**
+ * Sum of all the elements
+ */
+template<typename T>
+T sum(const NdArray<T>& array, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Sum along an axis
+ * @throws std::out_of_range
+ *  If the axis does not exist
+ */
+template<typename T>
+NdArray<T> sum(const NdArray<T>& array, size_t axis, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Mean of all the elements. NaN for an empty array.
+ */
+template<typename T>
+FloatingType<T> mean(const NdArray<T>& array, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Mean along an axis
+ * @throws std::out_of_range
+ *  If the axis does not exist
+ */
+template<typename T>
+NdArray<FloatingType<T>> mean(const NdArray<T>& array, size_t axis, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Minimum of all the elements
+ * @throws std::invalid_argument
+ *  If the array is empty
+ */
+template<typename T>
+T min(const NdArray<T>& array, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Minimum along an axis
+ * @throws std::out_of_range
+ *  If the axis does not exist
+ * @throws std::invalid_argument
+ *  If the axis is empty
+ */
+template<typename T>
+NdArray<T> min(const NdArray<T>& array, size_t axis, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Maximum of all the elements
+ * @throws std::invalid_argument
+ *  If the array is empty
+ */
+template<typename T>
+T max(const NdArray<T>& array, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Maximum along an axis
+ * @throws std::out_of_range
+ *  If the axis does not exist
+ * @throws std::invalid_argument
+ *  If the axis is empty
+ */
+template<typename T>
+NdArray<T> max(const NdArray<T>& array, size_t axis, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Position, in row-major order, of the first occurrence of the minimum
+ * @throws std::invalid_argument
+ *  If the array is empty
+ */
+template<typename T>
+size_t argmin(const NdArray<T>& array, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Index along the axis of the first occurrence of the minimum
+ * @throws std::out_of_range
+ *  If the axis does not exist
+ * @throws std::invalid_argument
+ *  If the axis is empty
+ */
+template<typename T>
+NdArray<size_t> argmin(const NdArray<T>& array, size_t axis, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Position, in row-major order, of the first occurrence of the maximum
+ * @throws std::invalid_argument
+ *  If the array is empty
+ */
+template<typename T>
+size_t argmax(const NdArray<T>& array, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Index along the axis of the first occurrence of the maximum
+ * @throws std::out_of_range
+ *  If the axis does not exist
+ * @throws std::invalid_argument
+ *  If the axis is empty
+ */
+template<typename T>
+NdArray<size_t> argmax(const NdArray<T>& array, size_t axis, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * p-norm of all the elements, (sum |x|^p)^(1/p)
+ * @param order
+ *  p. It can be infinity, for the maximum absolute value.
+ * @throws std::invalid_argument
+ *  If the order is not positive
+ */
+template<typename T>
+FloatingType<T> norm(const NdArray<T>& array, double order = 2, ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * p-norm along an axis
+ * @throws std::out_of_range
+ *  If the axis does not exist
+ * @throws std::invalid_argument
+ *  If the order is not positive
+ */
+template<typename T>
+NdArray<FloatingType<T>> norm(const NdArray<T>& array, size_t axis, double order,
+                              ThreadPool& pool = ThreadPool::defaultPool());
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#include "NdArray/_impl/Reductions.icpp"
+
+#endif // ALEXANDRIA_NDARRAY_REDUCTIONS_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file NdArray/Span.h
+ * @author Alejandro Alvarez Ayllon
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_SPAN_H
+#define ALEXANDRIA_NDARRAY_SPAN_H
+
+#include <cstddef>
+
+namespace Euclid {
+namespace NdArray {
+
+/**
+ * Non owning view over a contiguous sequence of elements, similar to std::span.
+ * Its iterators are plain pointers, so loops over a Span can be vectorized, and the memory
+ * can be handed to external libraries.
+ * @tparam T
+ *  Element type. Use a const type for read-only access.
+ */
+template<typename T>
+class Span {
+public:
+  typedef T value_type;
+  typedef T* iterator;
+
+  Span() : m_data(nullptr), m_size(0) {}
+
+  Span(T *data, size_t size) : m_data(data), m_size(size) {}
+
+  /// A Span<T> can be converted to a Span<const T>
+  template<typename U>
+  Span(const Span<U>& other) : m_data(other.data()), m_size(other.size()) {}
+
+  T *data() const {
+    return m_data;
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  bool empty() const {
+    return m_size == 0;
+  }
+
+  T& operator[](size_t i) const {
+    return m_data[i];
+  }
+
+  iterator begin() const {
+    return m_data;
+  }
+
+  iterator end() const {
+    return m_data + m_size;
+  }
+
+private:
+  T *m_data;
+  size_t m_size;
+};
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#endif // ALEXANDRIA_NDARRAY_SPAN_H
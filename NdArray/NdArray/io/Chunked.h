@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_IO_CHUNKED_H
+#define ALEXANDRIA_NDARRAY_IO_CHUNKED_H
+
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "AlexandriaKernel/ThreadPool.h"
+#include "NdArray/NdArray.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/// Compression applied to each chunk
+enum class ChunkCodec : uint8_t {
+  /// Chunks are stored raw
+  NONE = 0,
+  /// Chunks are compressed with zlib (deflate), after grouping the bytes of the values by significance
+  ZLIB = 1
+};
+
+/**
+ * Write an NdArray split in chunks, each one compressed independently
+ * @details
+ *  The file starts with the chunk shape, the description of the array as an npy header,
+ *  and an index with the position of every chunk. The chunks follow, in row-major order,
+ *  each one with its values in row-major order. Chunks on the edges are not padded.
+ *  The chunks are compressed in parallel, a few of them per worker at a time,
+ *  so the memory overhead does not depend on the size of the array.
+ * @tparam T
+ *  NdArray cell type
+ * @param path
+ *  Output path
+ * @param array
+ *  NdArray to write. It can be a view.
+ * @param chunk_shape
+ *  Shape of the chunks, with the same number of dimensions as the array.
+ *  Larger than the array on an axis means a single chunk on that axis.
+ * @param codec
+ *  Compression
+ * @param pool
+ *  Pool for the compression
+ * @throws std::invalid_argument
+ *  If the chunk shape does not have the dimensionality of the array, or has a 0 size
+ * @throws Elements::Exception
+ *  If the file can not be written
+ */
+template<typename T>
+void writeChunked(const boost::filesystem::path& path, const NdArray<T>& array,
+                  const std::vector<size_t>& chunk_shape, ChunkCodec codec = ChunkCodec::ZLIB,
+                  ThreadPool& pool = ThreadPool::defaultPool());
+
+/**
+ * Reader for the files written by writeChunked
+ * @details
+ *  The file is memory mapped, and only the index is read when it is opened. A read
+ *  decompresses in parallel only the chunks that overlap the requested region.
+ *  The reader can be used concurrently.
+ */
+class ChunkedReader {
+public:
+  /**
+   * Constructor
+   * @param path
+   *  Input path
+   * @throws Elements::Exception
+   *  If the file is not a chunked NdArray
+   */
+  explicit ChunkedReader(const boost::filesystem::path& path);
+
+  /**
+   * @return The shape of the stored array, including the attribute axis, if any
+   */
+  const std::vector<size_t>& shape() const {
+    return m_shape;
+  }
+
+  /**
+   * @return The shape of the chunks
+   */
+  const std::vector<size_t>& chunkShape() const {
+    return m_chunk_shape;
+  }
+
+  /**
+   * @return The attribute names of the stored array
+   */
+  const std::vector<std::string>& attributes() const {
+    return m_attrs;
+  }
+
+  /**
+   * @return The codec used for the chunks
+   */
+  ChunkCodec codec() const {
+    return m_codec;
+  }
+
+  /**
+   * Read the whole array
+   * @tparam T
+   *  NdArray cell type. It must match the stored type.
+   * @throws Elements::Exception
+   *  If the stored type is not T, or the file is corrupted
+   */
+  template<typename T>
+  NdArray<T> read(ThreadPool& pool = ThreadPool::defaultPool()) const;
+
+  /**
+   * Read a region of the array
+   * @tparam T
+   *  NdArray cell type. It must match the stored type.
+   * @param start
+   *  First coordinate of the region on each axis
+   * @param count
+   *  Size of the region on each axis
+   * @param pool
+   *  Pool for the decompression
+   * @return
+   *  A new NdArray with the shape `count`. If the array has attributes, the result keeps the names
+   *  of the ones within the region.
+   * @throws std::out_of_range
+   *  If the region is not within the array
+   * @throws Elements::Exception
+   *  If the stored type is not T, or the file is corrupted
+   */
+  template<typename T>
+  NdArray<T> read(const std::vector<size_t>& start, const std::vector<size_t>& count,
+                  ThreadPool& pool = ThreadPool::defaultPool()) const;
+
+private:
+  boost::filesystem::path m_path;
+  boost::iostreams::mapped_file_source m_mapped;
+  std::string m_dtype;
+  ChunkCodec m_codec;
+  bool m_shuffle;
+  std::vector<size_t> m_shape, m_chunk_shape;
+  std::vector<std::string> m_attrs;
+  /// Offset and size of each chunk
+  std::vector<std::pair<uint64_t, uint64_t>> m_index;
+};
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#define CHUNKED_IMPL
+#include "NdArray/io/_impl/Chunked.icpp"
+#undef CHUNKED_IMPL
+
+#endif // ALEXANDRIA_NDARRAY_IO_CHUNKED_H
@@ -25,6 +25,14 @@
 namespace Euclid {
 namespace NdArray {
 
+/// How readNpy handles files whose values are not stored as T
+enum class NpyReadMode {
+  /// The dtype and the byte order of the file must match T
+  STRICT,
+  /// Numeric values are converted to T, and swapped to the native byte order, while they are read
+  CONVERT
+};
+
 /**
  * Write an NdArray to a file following numpy format
  * @see
@@ -37,6 +45,9 @@ namespace NdArray {
  *  Output stream
  * @param array
  *  NdArray to write
+ * @note
+ *  If the array is a view with its elements in column-major order (i.e. the transposition of an array),
+ *  it is written as it is in memory, in Fortran order.
  */
 template<typename T>
 void writeNpy(std::ostream& out, const NdArray<T>& array);
@@ -49,13 +60,20 @@ void writeNpy(std::ostream& out, const NdArray<T>& array);
  *  NdArray container type
  * @param input
  *  Input stream
+ * @param mode
+ *  With NpyReadMode::STRICT, the underlying numpy format is expected to match the template type T.
+ *  With NpyReadMode::CONVERT, any numeric type and byte order is accepted. The data is read in chunks
+ *  and converted into the NdArray, so there is no intermediate copy of the whole array.
  * @return
  *  A new NdArray
+ * @throws Elements::Exception
+ *  If the data type can not be read into T
  * @note
- *  The underlying numpy format is expected to match the template type T
+ *  Arrays stored in Fortran order are returned as a view with the same layout as the file.
+ *  Use asContiguous (NdArray/Contiguous.h) to get them in row-major order.
  */
 template<typename T>
-NdArray<T> readNpy(std::istream& input);
+NdArray<T> readNpy(std::istream& input, NpyReadMode mode = NpyReadMode::STRICT);
 
 
 /**
@@ -84,15 +102,17 @@ void writeNpy(const boost::filesystem::path& path, const NdArray<T>& array) {
  *  NdArray container type
  * @param path
  *  Input path
+ * @param mode
+ *  How to handle a data type different from T
  * @return
  *  A new NdArray
- * @note
- *  The underlying numpy format is expected to match the template type T
+ * @throws Elements::Exception
+ *  If the data type can not be read into T
  */
 template<typename T>
-NdArray<T> readNpy(const boost::filesystem::path& path) {
+NdArray<T> readNpy(const boost::filesystem::path& path, NpyReadMode mode = NpyReadMode::STRICT) {
   std::ifstream input(path.native(), std::ios_base::in | std::ios_base::binary);
-  return readNpy<T>(input);
+  return readNpy<T>(input, mode);
 }
 
 
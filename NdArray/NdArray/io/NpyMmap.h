@@ -44,6 +44,8 @@ namespace NdArray {
  *  The underlying numpy format is expected to match the template type T
  * @note
  *  If you open in read-only mode, assign to a const NdArray to avoid accidental writes
+ * @note
+ *  Arrays stored in Fortran order are mapped as a transposed view, so they can not be concatenated
  */
 template<typename T>
 NdArray<T> mmapNpy(const boost::filesystem::path& path,
@@ -88,6 +90,63 @@ NdArray<T> createMmapNpy(const boost::filesystem::path& path, const std::vector<
   return createMmapNpy<T>(path, shape, {}, max_size);
 }
 
+/// Expected access pattern of a memory mapped array
+enum class MmapAccess {
+  /// Default readahead
+  NORMAL,
+  /// The array will be read in order: aggressive readahead, and pages can be freed soon after being read
+  SEQUENTIAL,
+  /// The array will be accessed in random order: no readahead
+  RANDOM
+};
+
+/**
+ * Tell the kernel how the memory of an array is going to be accessed, so it can adjust the readahead
+ * @param array
+ *  Memory mapped NdArray, or a view of it
+ * @param access
+ *  Expected access pattern
+ * @throws Elements::Exception
+ *  If the kernel rejects the advice
+ */
+template<typename T>
+void adviseAccess(const NdArray<T>& array, MmapAccess access);
+
+/**
+ * Ask the kernel to start reading a range of rows (i.e. entries of the first axis) in the background,
+ * so they are already in memory when they are accessed
+ * @param array
+ *  Memory mapped NdArray, or a view of it
+ * @param first
+ *  First row
+ * @param count
+ *  Number of rows
+ * @throws std::out_of_range
+ *  If the range is not within the array
+ * @throws Elements::Exception
+ *  If the kernel rejects the advice
+ */
+template<typename T>
+void prefetch(const NdArray<T>& array, size_t first, size_t count);
+
+/**
+ * Release the memory of a range of rows that are not going to be accessed soon.
+ * Their content is kept, and it is read again from the file if they are accessed, so this is only a hint.
+ * Only the pages that are entirely within the range are released, so other rows are not affected.
+ * @param array
+ *  Memory mapped NdArray, or a view of it
+ * @param first
+ *  First row
+ * @param count
+ *  Number of rows
+ * @throws std::out_of_range
+ *  If the range is not within the array
+ * @note
+ *  It relies on MADV_PAGEOUT (Linux 5.4), and it has no effect where this is not available
+ */
+template<typename T>
+void evict(const NdArray<T>& array, size_t first, size_t count);
+
 } // end of namespace NdArray
 } // end of namespace Euclid
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_IO_NPYRECORDS_H
+#define ALEXANDRIA_NDARRAY_IO_NPYRECORDS_H
+
+#include <iosfwd>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "NdArray/RecordArray.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/**
+ * Read a numpy structured array, whose fields may have different types
+ * @details
+ *  The records are read in chunks, and each field is copied into its own contiguous column
+ *  with the type it has on the file, so there is no conversion nor intermediate copy of the whole file.
+ *  Values stored with a different byte order are swapped.
+ * @param input
+ *  Input stream
+ * @return
+ *  A new RecordArray, with a field per named field of the file. Padding is skipped.
+ * @throws Elements::Exception
+ *  If the file does not contain a structured array, or a field has a type that is not supported
+ *  (only numeric scalars are)
+ * @note
+ *  For arrays stored in Fortran order, the fields are views with the same layout as the file.
+ */
+RecordArray readNpyRecords(std::istream& input);
+
+/**
+ * Read a numpy structured array
+ * @param path
+ *  Input path
+ * @see readNpyRecords(std::istream&)
+ */
+RecordArray readNpyRecords(const boost::filesystem::path& path);
+
+/**
+ * Write a RecordArray as a numpy structured array, with the fields in the order they were added
+ * @param out
+ *  Output stream
+ * @param records
+ *  RecordArray to write. The fields can be views.
+ * @throws Elements::Exception
+ *  If the RecordArray has no fields, or a field has a type that can not be stored on an npy file
+ */
+void writeNpy(std::ostream& out, const RecordArray& records);
+
+/**
+ * Write a RecordArray as a numpy structured array
+ * @param path
+ *  Output path
+ * @param records
+ *  RecordArray to write
+ */
+void writeNpy(const boost::filesystem::path& path, const RecordArray& records);
+
+/**
+ * Open using mmap an existing numpy structured array
+ * @details
+ *  Fields stored with the native byte order and aligned to their type are views of the mapped file,
+ *  with a stride of the size of a record, so they are not copied and, in read/write mode, changes persist.
+ *  The rest of fields are copied into a contiguous column, as readNpyRecords does.
+ * @param path
+ *  Input path
+ * @param mode
+ *  Open mode
+ * @return
+ *  A new RecordArray
+ * @throws Elements::Exception
+ *  If the file does not contain a structured array, or a field has a type that is not supported
+ */
+RecordArray mmapNpyRecords(const boost::filesystem::path& path,
+                           boost::iostreams::mapped_file_base::mapmode mode = boost::iostreams::mapped_file_base::readwrite);
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#define NPYRECORDS_IMPL
+#include "NdArray/io/_impl/NpyRecords.icpp"
+#undef NPYRECORDS_IMPL
+
+#endif // ALEXANDRIA_NDARRAY_IO_NPYRECORDS_H
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ALEXANDRIA_NDARRAY_IO_NPZ_H
+#define ALEXANDRIA_NDARRAY_IO_NPZ_H
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include "NdArray/NdArray.h"
+#include "NdArray/io/Npy.h"
+
+namespace Euclid {
+namespace NdArray {
+
+/**
+ * Reader for .npz archives, as written by numpy.savez and numpy.savez_compressed
+ * @see
+ *  https://numpy.org/devdocs/reference/generated/numpy.lib.format.html
+ * @details
+ *  The archive is mapped into memory once, when it is opened, and only its directory is parsed.
+ *  The arrays are loaded when they are requested:
+ *  - Stored (uncompressed) members with the native byte order are memory mapped, through a MappedContainer,
+ *    and the NdArray shares the mapping with the reader.
+ *  - Compressed members are decompressed the first time they are requested, and kept for the next calls.
+ *  Arrays returned by get share their memory with the reader, like copies of an NdArray do.
+ *  By default the archive is mapped copy-on-write, so the arrays can be modified, but the changes
+ *  are not written to the archive.
+ */
+class NpzReader {
+public:
+  /**
+   * Constructor
+   * @param path
+   *  Path of the archive
+   * @param mode
+   *  Open mode for the stored members. By default boost::iostreams::mapped_file_base::priv,
+   *  so the memory can be modified, but the changes do not persist.
+   *  With boost::iostreams::mapped_file_base::readonly the pages are shared with other readers of the file,
+   *  but writing to a mapped array crashes the process: assign them to a const NdArray.
+   * @throws Elements::Exception
+   *  If the file is not a zip archive
+   */
+  explicit NpzReader(const boost::filesystem::path& path,
+                     boost::iostreams::mapped_file_base::mapmode mode = boost::iostreams::mapped_file_base::priv);
+
+  /**
+   * @return The names of the arrays, in the order they are stored and without the .npy extension
+   */
+  const std::vector<std::string>& names() const;
+
+  /**
+   * @return true if the archive contains an array with the given name
+   */
+  bool contains(const std::string& name) const;
+
+  /**
+   * Get an array from the archive
+   * @tparam T
+   *  NdArray cell type
+   * @param name
+   *  Name of the array, with or without the .npy extension
+   * @param mode
+   *  How to handle a data type different from T. Stored members are mapped only if their
+   *  data type is T, and read into memory otherwise.
+   * @throws std::out_of_range
+   *  If there is no such array
+   * @throws Elements::Exception
+   *  If the data type can not be read into T, or the member uses an unsupported compression method
+   * @note
+   *  This method can be called concurrently
+   */
+  template<typename T>
+  NdArray<T> get(const std::string& name, NpyReadMode mode = NpyReadMode::STRICT) const;
+
+private:
+  struct Member {
+    uint16_t method;
+    uint16_t flags;
+    uint64_t compressed_size, uncompressed_size, header_offset;
+  };
+
+  boost::filesystem::path m_path;
+  boost::iostreams::mapped_file m_mapped;
+  std::vector<std::string> m_names;
+  std::map<std::string, Member> m_members;
+
+  mutable std::mutex m_cache_mutex;
+  // Decompressed members, by name, type and read mode, so a strict read never returns a converted copy
+  mutable std::map<std::tuple<std::string, std::type_index, NpyReadMode>, std::shared_ptr<void>> m_cache;
+
+  const Member& find_member(const std::string& name, std::string& key) const;
+  size_t data_offset(const Member& member) const;
+};
+
+/**
+ * Writer for .npz archives, readable with numpy.load
+ * @details
+ *  The arrays are serialized straight into the archive. Stored members are aligned to 64 bytes,
+ *  so NpzReader can map them into memory.
+ *  Archives bigger than 4 GiB, or with more than 65535 members, use the Zip64 extensions.
+ */
+class NpzWriter {
+public:
+  /**
+   * Constructor
+   * @param path
+   *  Path of the archive. It is overwritten if it exists.
+   * @param compress
+   *  If true, the members are compressed with deflate, as numpy.savez_compressed does
+   */
+  explicit NpzWriter(const boost::filesystem::path& path, bool compress = false);
+
+  /**
+   * Destructor. Closes the archive if close has not been called.
+   */
+  ~NpzWriter();
+
+  /**
+   * Add an array to the archive
+   * @param name
+   *  Name of the array, without the .npy extension
+   * @param array
+   *  NdArray to write
+   * @throws Elements::Exception
+   *  If there is already an array with that name, or the archive has been closed
+   */
+  template<typename T>
+  void add(const std::string& name, const NdArray<T>& array);
+
+  /**
+   * Write the directory of the archive and close it. No more arrays can be added afterwards.
+   * @throws Elements::Exception
+   *  If the archive can not be written
+   */
+  void close();
+
+private:
+  struct Entry {
+    std::string filename;
+    uint16_t method;
+    uint32_t crc;
+    uint64_t compressed_size, uncompressed_size, header_offset;
+  };
+
+  std::ofstream m_output;
+  bool m_compress, m_closed;
+  std::vector<Entry> m_entries;
+};
+
+} // end of namespace NdArray
+} // end of namespace Euclid
+
+#define NPZ_IMPL
+#include "NdArray/io/_impl/Npz.icpp"
+#undef NPZ_IMPL
+
+#endif // ALEXANDRIA_NDARRAY_IO_NPZ_H
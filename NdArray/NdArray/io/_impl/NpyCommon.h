@@ -19,17 +19,42 @@
 #ifndef ALEXANDRIA_NDARRAY_IMPL_NPYCOMMON_H
 #define ALEXANDRIA_NDARRAY_IMPL_NPYCOMMON_H
 
+#include <cstring>
 #include <boost/endian/arithmetic.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/regex.hpp>
 #include "AlexandriaKernel/StringUtils.h"
+#include "NdArray/NdArray.h"
 
 namespace Euclid {
 namespace NdArray {
 
 using boost::endian::little_uint16_t;
 using boost::endian::little_uint32_t;
+using boost::endian::little_uint64_t;
+
+/**
+ * Load an integer stored in little endian at an arbitrary address
+ * @tparam L
+ *  One of the boost::endian little endian types
+ */
+template<typename L>
+uint64_t loadLittle(const char *p) {
+  L value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/**
+ * Write an integer in little endian
+ * @tparam L
+ *  One of the boost::endian little endian types
+ */
+template<typename L>
+void writeLittle(std::ostream& out, L value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
 
 /**
  * Magic string for .npy files
@@ -112,40 +137,125 @@ inline void parseSingleValue(const std::string& descr, bool& big_endian, std::st
   dtype = descr.substr(1);
 }
 
+/**
+ * A field of a numpy structured type
+ */
+struct NpyField {
+  /// Name. It is empty for the padding between fields.
+  std::string name;
+  /// Type, without the byte order
+  std::string dtype;
+  bool big_endian;
+  /// Position within the record, in bytes
+  size_t offset;
+  /// Size, in bytes
+  size_t size;
+};
+
+/**
+ * Size in bytes of a numpy type (i.e. 'f8', or 'U10')
+ * @throws Elements::Exception
+ *  If the size is not known
+ */
+inline size_t npyItemSize(const std::string& dtype) {
+  if (dtype == "b" || dtype == "B" || dtype == "?")
+    return 1;
+  size_t digits = dtype.find_first_not_of("0123456789", 1);
+  if (dtype.size() < 2 || digits == 1)
+    throw Elements::Exception() << "Unknown size of the type " << dtype;
+  size_t size = std::stoul(dtype.substr(1, digits - 1));
+  // Unicode strings are stored in UCS4
+  return (dtype.front() == 'U') ? size * 4 : size;
+}
+
 /**
  * Parse the description field from npy arrays with named fields, which are stored as the
  * string representation of a list of tuples (name, dtype). i.e:
- * [('a', '<i4'), ('b', '<i4')]
- * @throws std::invalid_argument
- *  NdArrays only support uniform types, so this method will fail if there are mixed types on the
- *  npy file
+ * [('a', '<i4'), ('b', '<f8')]
+ * @param record_size [out]
+ *  Put here the size of a record
+ * @throws Elements::Exception
+ *  If a field is an array itself (i.e. ('a', '<i4', (2,)))
  */
-inline void parseFieldValues(const std::string& descr, bool& big_endian, std::vector<std::string>& attrs,
-                             std::string& dtype) {
-  static const boost::regex field_expr("\\('([^']*)',\\s*'([^']*)'\\)");
+inline std::vector<NpyField> parseFieldDescriptions(const std::string& descr, size_t& record_size) {
+  static const boost::regex field_expr("\\('([^']*)',\\s*'([^']*)'(\\s*,\\s*\\([^)]*\\))?\\)");
 
   boost::match_results<std::string::const_iterator> match;
   auto start = descr.begin();
   auto end = descr.end();
 
+  std::vector<NpyField> fields;
+  record_size = 0;
   while (boost::regex_search(start, end, match, field_expr)) {
-    bool endian_aux;
-    std::string dtype_aux;
+    if (match[3].matched) {
+      throw Elements::Exception() << "Fields with a shape are not supported: " << match[0].str();
+    }
+    NpyField field;
+    field.name = match[1].str();
+    parseSingleValue(match[2].str(), field.big_endian, field.dtype);
+    field.offset = record_size;
+    field.size = npyItemSize(field.dtype);
+    record_size += field.size;
+    fields.emplace_back(std::move(field));
+
+    start = match[0].second;
+  }
+  return fields;
+}
 
-    parseSingleValue(match[2].str(), endian_aux, dtype_aux);
+/**
+ * Parse the description field from npy arrays with named fields
+ * @throws std::invalid_argument
+ *  NdArrays only support uniform types, so this method will fail if there are mixed types on the
+ *  npy file. Use readNpyRecords (NdArray/io/NpyRecords.h) for those.
+ */
+inline void parseFieldValues(const std::string& descr, bool& big_endian, std::vector<std::string>& attrs,
+                             std::string& dtype) {
+  size_t record_size;
+  for (auto& field : parseFieldDescriptions(descr, record_size)) {
     if (dtype.empty()) {
-      dtype = dtype_aux;
-      big_endian = endian_aux;
+      dtype = field.dtype;
+      big_endian = field.big_endian;
     }
-    else if (dtype != dtype_aux || big_endian != endian_aux) {
+    else if (dtype != field.dtype || big_endian != field.big_endian) {
       throw std::invalid_argument("NdArray only supports uniform types");
     }
-    attrs.emplace_back(match[1].str());
-
-    start = match[0].second;
+    attrs.emplace_back(field.name);
   }
 }
 
+/**
+ * Position of the value of a key of the dictionary serialized on the npy file
+ * @throws Elements::Exception
+ *  If the key is missing
+ */
+inline size_t npyDictValue(const std::string& header, const std::string& key) {
+  // Quoted and followed by ':', so a field with the same name is not mistaken for the key
+  auto loc = header.find('\'' + key + "':");
+  if (loc == std::string::npos)
+    throw Elements::Exception() << "Missing " << key << " in the npy header: " << header;
+  return header.find_first_not_of(' ', loc + key.size() + 3);
+}
+
+/**
+ * Parse the memory layout from the dictionary serialized on the npy file
+ * @param fortran_order [out]
+ *  Put here if the numpy array follows the Fortran convention
+ * @param shape [out]
+ *  Put here the read shape
+ */
+inline void parseNpyLayout(const std::string& header, bool& fortran_order, std::vector<size_t>& shape) {
+  auto loc = npyDictValue(header, "fortran_order");
+  fortran_order = (header.substr(loc, 4) == "True");
+
+  loc = npyDictValue(header, "shape") + 1;
+  auto loc2 = header.find(')', loc);
+  auto shape_str = header.substr(loc, loc2 - loc);
+  if (!shape_str.empty() && shape_str.back() == ',')
+    shape_str.resize(shape_str.size() - 1);
+  shape = stringToVector<size_t>(shape_str);
+}
+
 /**
  * Parse the dictionary serialized on the npy file
  * @param header
@@ -166,11 +276,9 @@ inline void parseFieldValues(const std::string& descr, bool& big_endian, std::ve
 inline void parseNpyDict(const std::string& header, bool& fortran_order, bool& big_endian,
                          std::string& dtype, std::vector<size_t>& shape, std::vector<std::string>& attrs,
                          size_t& n_elements) {
-  auto loc = header.find("fortran_order") + 16;
-  fortran_order = (header.substr(loc, 4) == "True");
-
-  loc = header.find("descr") + 8;
+  parseNpyLayout(header, fortran_order, shape);
 
+  auto loc = npyDictValue(header, "descr");
   if (header[loc] == '\'') {
     auto end = header.find('\'', loc + 1);
     parseSingleValue(header.substr(loc + 1, end - loc - 1), big_endian, dtype);
@@ -183,31 +291,13 @@ inline void parseNpyDict(const std::string& header, bool& fortran_order, bool& b
     throw Elements::Exception() << "Failed to parse the array description: " << header;
   }
 
-  loc = header.find("shape") + 9;
-  auto loc2 = header.find(')', loc);
-  auto shape_str = header.substr(loc, loc2 - loc);
-  if (shape_str.back() == ',')
-    shape_str.resize(shape_str.size() - 1);
-  shape = stringToVector<size_t>(shape_str);
   n_elements = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<size_t>());
 }
 
 /**
- * Read the npy header
- * @param input
- *  Input stream
- * @param dtype [out]
- *  Put here the read dtype
- * @param shape [out]
- *  Put here the read shape
- * @param attrs [out]
- *  Put here the attribute names
- * @param n_elements [out]
- *  Total number of elements (multiplication of shape)
- * @return
+ * Read the dictionary serialized on the npy file, checking the magic and the version
  */
-inline void readNpyHeader(std::istream& input, std::string& dtype, std::vector<size_t>& shape,
-                          std::vector<std::string>& attrs, size_t& n_elements) {
+inline std::string readNpyDict(std::istream& input) {
   // Magic
   char magic[6];
   input.read(magic, sizeof(magic));
@@ -236,10 +326,78 @@ inline void readNpyHeader(std::istream& input, std::string& dtype, std::vector<s
   // Read header
   std::string header(header_len, '\0');
   input.read(&header[0], header_len);
+  return header;
+}
 
-  // Parse header
-  bool fortran_order, big_endian;
+/**
+ * Read the npy header, without checking if the layout is supported
+ * @param input
+ *  Input stream
+ * @param dtype [out]
+ *  Put here the read dtype
+ * @param big_endian [out]
+ *  Put here if the data is stored in big-endian
+ * @param fortran_order [out]
+ *  Put here if the data follows the Fortran convention
+ * @param shape [out]
+ *  Put here the read shape
+ * @param attrs [out]
+ *  Put here the attribute names
+ * @param n_elements [out]
+ *  Total number of elements (multiplication of shape)
+ */
+inline void readNpyHeader(std::istream& input, std::string& dtype, bool& big_endian, bool& fortran_order,
+                          std::vector<size_t>& shape, std::vector<std::string>& attrs, size_t& n_elements) {
+  auto header = readNpyDict(input);
   parseNpyDict(header, fortran_order, big_endian, dtype, shape, attrs, n_elements);
+}
+
+/**
+ * Read the npy header of a structured array
+ * @param input
+ *  Input stream
+ * @param fortran_order [out]
+ *  Put here if the data follows the Fortran convention
+ * @param shape [out]
+ *  Put here the read shape
+ * @param fields [out]
+ *  Put here the fields of the records, including the padding
+ * @param record_size [out]
+ *  Put here the size of a record, in bytes
+ * @throws Elements::Exception
+ *  If the array is not a structured array
+ */
+inline void readNpyRecordHeader(std::istream& input, bool& fortran_order, std::vector<size_t>& shape,
+                                std::vector<NpyField>& fields, size_t& record_size) {
+  auto header = readNpyDict(input);
+  parseNpyLayout(header, fortran_order, shape);
+
+  auto loc = npyDictValue(header, "descr");
+  if (header[loc] != '[')
+    throw Elements::Exception() << "The npy file does not contain records: " << header;
+  auto end = header.find(']', loc + 1);
+  fields = parseFieldDescriptions(header.substr(loc + 1, end - loc - 1), record_size);
+}
+
+/**
+ * Read the npy header
+ * @param input
+ *  Input stream
+ * @param dtype [out]
+ *  Put here the read dtype
+ * @param shape [out]
+ *  Put here the read shape
+ * @param attrs [out]
+ *  Put here the attribute names
+ * @param n_elements [out]
+ *  Total number of elements (multiplication of shape)
+ * @throws Elements::Exception
+ *  If the data is not stored in C order and native endianness
+ */
+inline void readNpyHeader(std::istream& input, std::string& dtype, std::vector<size_t>& shape,
+                          std::vector<std::string>& attrs, size_t& n_elements) {
+  bool fortran_order, big_endian;
+  readNpyHeader(input, dtype, big_endian, fortran_order, shape, attrs, n_elements);
 
   if (fortran_order)
     throw Elements::Exception() << "Fortran order not supported";
@@ -285,33 +443,41 @@ inline std::string typeDescription(const std::string& type, const std::vector<st
 }
 
 /**
- * Write header
+ * Write the header for the given type description
+ * @param descr
+ *  Python representation of the dtype
+ * @param shape
+ *  Shape, without the attributes
+ * @param fortran_order
+ *  If true, the data that follows is stored in column-major order
+ * @param header_size
+ *  If not 0, pad the header to exactly this number of bytes instead of the next multiple of 64
  */
-template<typename T>
-void writeNpyHeader(std::ostream& out, std::vector<size_t> shape, const std::vector<std::string>& attrs) {
-  if (!attrs.empty()) {
-    if (attrs.size() != shape.back()) {
-      throw std::out_of_range("Last axis does not match number of attribute names");
-    }
-    shape.pop_back();
-  }
+inline void writeNpyDict(std::ostream& out, const std::string& descr, const std::vector<size_t>& shape,
+                         bool fortran_order, size_t header_size = 0) {
   // Serialize header as a Python dict
   std::stringstream header;
   header << "{"
-         << "'descr': " << typeDescription(NpyDtype<T>::str, attrs) << ", 'fortran_order': False, 'shape': "
+         << "'descr': " << descr
+         << ", 'fortran_order': " << (fortran_order ? "True" : "False") << ", 'shape': "
          << npyShape(shape)
          << "}";
   auto header_str = header.str();
   little_uint32_t header_len = header_str.size();
 
   // Pad header with spaces so the header block is 64 bytes aligned
-  size_t total_length = sizeof(NPY_MAGIC) + sizeof(NPY_VERSION) + sizeof(header_len) + header_len - 1; // Keep 1 for \n
-  size_t padding = 64 - total_length % 64;
-  if (padding) {
-    header << std::string(padding, '\x20') << '\n';
-    header_str = header.str();
-    header_len = header_str.size();
+  size_t total_length = sizeof(NPY_MAGIC) + sizeof(NPY_VERSION) + sizeof(header_len) + header_len + 1; // 1 for \n
+  size_t padding = (64 - total_length % 64) % 64;
+  if (header_size) {
+    if (total_length > header_size) {
+      throw Elements::Exception() << "The NPY header needs " << total_length << " bytes, but only " << header_size
+                                  << " are available";
+    }
+    padding = header_size - total_length;
   }
+  header << std::string(padding, '\x20') << '\n';
+  header_str = header.str();
+  header_len = header_str.size();
 
   // Magic and version
   out.write(NPY_MAGIC, sizeof(NPY_MAGIC));
@@ -324,6 +490,60 @@ void writeNpyHeader(std::ostream& out, std::vector<size_t> shape, const std::vec
   out.write(header_str.data(), header_str.size());
 }
 
+/**
+ * Write header
+ * @param fortran_order
+ *  If true, the data that follows is stored in column-major order
+ * @param header_size
+ *  If not 0, pad the header to exactly this number of bytes
+ */
+template<typename T>
+void writeNpyHeader(std::ostream& out, std::vector<size_t> shape, const std::vector<std::string>& attrs,
+                    bool fortran_order = false, size_t header_size = 0) {
+  if (!attrs.empty()) {
+    if (attrs.size() != shape.back()) {
+      throw std::out_of_range("Last axis does not match number of attribute names");
+    }
+    shape.pop_back();
+  }
+  writeNpyDict(out, typeDescription(NpyDtype<T>::str, attrs), shape, fortran_order, header_size);
+}
+
+/**
+ * Axes that transpose an array stored in Fortran order into one with the shape
+ * described in the header. The axis of the attributes, if any, stays the last one.
+ * @param ndim
+ *  Number of dimensions, without counting the attributes
+ * @param has_attrs
+ *  True if the array has attribute names
+ */
+inline std::vector<size_t> fortranAxes(size_t ndim, bool has_attrs) {
+  std::vector<size_t> axes;
+  for (size_t i = ndim; i > 0; --i) {
+    axes.emplace_back(i - 1);
+  }
+  if (has_attrs)
+    axes.emplace_back(ndim);
+  return axes;
+}
+
+/**
+ * Build the view over an array stored in Fortran order
+ * @param shape
+ *  Shape as described in the header, without the attributes
+ * @param attrs
+ *  Attribute names
+ * @param data
+ *  Container with the data, in the order it is stored
+ */
+template<typename T, typename Container>
+NdArray<T> fortranView(const std::vector<size_t>& shape, const std::vector<std::string>& attrs, Container&& data) {
+  // The data, read in C order, has the axes in reverse order
+  std::vector<size_t> stored_shape(shape.rbegin(), shape.rend());
+  NdArray<T> stored{stored_shape, attrs, std::forward<Container>(data)};
+  return stored.transpose(fortranAxes(shape.size(), !attrs.empty()));
+}
+
 /**
  * A memory mapped container that can be used by NdArray.
  * Builds on top of boost::iostream::mapped_file
@@ -333,12 +553,19 @@ void writeNpyHeader(std::ostream& out, std::vector<size_t> shape, const std::vec
 template<typename T>
 class MappedContainer {
 public:
+  /**
+   * @param resizable
+   *  False if the data is not the only content of the file (i.e. a member of an archive),
+   *  so the file can not be resized nor remapped
+   */
   MappedContainer(const boost::filesystem::path& path, size_t data_offset, size_t n_elements,
                   const std::vector<std::string>& attr_names,
-                  boost::iostreams::mapped_file&& input, size_t max_size)
+                  boost::iostreams::mapped_file&& input, size_t max_size, bool resizable = true)
     : m_path(path), m_data_offset(data_offset), m_n_elements(n_elements),
-      m_max_size(max_size), m_attr_names(attr_names),
-      m_mapped(std::move(input)), m_data(reinterpret_cast<T *>(m_mapped.data() + data_offset)) {
+      m_max_size(max_size), m_resizable(resizable), m_attr_names(attr_names),
+      m_mapped(std::move(input)),
+      // data() is null for read-only mappings
+      m_data(reinterpret_cast<T *>(const_cast<char *>(m_mapped.const_data()) + data_offset)) {
   }
 
   size_t size() const {
@@ -350,16 +577,19 @@ public:
   }
 
   void resize(const std::vector<size_t>& shape) {
-    // Generate header
+    if (!m_resizable) {
+      throw Elements::Exception() << "Can not resize a memory mapped array that shares its file";
+    }
+    // Generate header, padded to the existing data offset so the data stays in place.
+    // Files written with a different padding (i.e. by an older writer, or by numpy) can still be resized.
     std::stringstream header;
-    writeNpyHeader<T>(header, shape, m_attr_names);
+    try {
+      writeNpyHeader<T>(header, shape, m_attr_names, false, m_data_offset);
+    } catch (const Elements::Exception& e) {
+      throw Elements::Exception() << "Can not resize memory mapped NPY file: " << e.what();
+    }
     auto header_str = header.str();
     auto header_size = header_str.size();
-    // Make sure we are in place
-    if (header_size != m_data_offset) {
-      throw Elements::Exception() << "Can not resize memory mapped NPY file. "
-                                     "The new header length must match the allocated space.";
-    }
 
     m_n_elements = std::accumulate(shape.begin(), shape.end(), 1u, std::multiplies<size_t>());
     size_t new_size = header_size + sizeof(T) * m_n_elements;
@@ -371,9 +601,54 @@ public:
     std::copy(header_str.begin(), header_str.end(), m_mapped.data());
   }
 
+  /**
+   * Number of elements that fit in the mapped region
+   */
+  size_t capacity() const {
+    return (m_max_size - m_data_offset) / sizeof(T);
+  }
+
+  /**
+   * Remap the file so it can grow up to n elements without remapping again.
+   * Only the mapping grows: the file itself is resized when the elements are added.
+   */
+  void reserve(size_t n) {
+    size_t length = m_data_offset + n * sizeof(T);
+    if (length > m_max_size)
+      remap(length);
+  }
+
+  /**
+   * Remap the file so the mapping covers only the current elements
+   */
+  void shrink_to_fit() {
+    size_t length = m_data_offset + m_n_elements * sizeof(T);
+    if (length < m_max_size)
+      remap(length);
+  }
+
 private:
+  void remap(size_t length) {
+    if (!m_resizable) {
+      throw Elements::Exception() << "Can not remap a memory mapped array that shares its file";
+    }
+    if (m_mapped.flags() != boost::iostreams::mapped_file_base::readwrite) {
+      throw Elements::Exception() << "Only read/write memory mapped NPY files can be remapped";
+    }
+    boost::iostreams::mapped_file_params map_params;
+    map_params.path = m_path.native();
+    map_params.flags = boost::iostreams::mapped_file_base::readwrite;
+    map_params.length = length;
+    // Map before unmapping, so the container stays valid if it fails
+    boost::iostreams::mapped_file remapped(map_params);
+    m_mapped = remapped;
+    m_data = reinterpret_cast<T *>(m_mapped.data() + m_data_offset);
+    m_max_size = length;
+  }
+
   boost::filesystem::path m_path;
   size_t m_data_offset, m_n_elements, m_max_size;
+  bool m_resizable;
   std::vector<std::string> m_attr_names;
   boost::iostreams::mapped_file m_mapped;
   T *m_data;
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+* @file tests/src/AlignedBuffer_test.cpp
+* @author Alejandro Alvarez Ayllon
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <string>
+#include "NdArray/AlignedBuffer.h"
+
+using namespace Euclid::NdArray;
+
+namespace {
+
+bool isAligned(const void *ptr, size_t alignment) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(AlignedBuffer_test)
+
+BOOST_AUTO_TEST_CASE(Alignment_test) {
+  AlignedBuffer<char> small{3};
+  BOOST_CHECK(isAligned(small.data(), AlignedBuffer<char>::alignment));
+  BOOST_CHECK_EQUAL(small.data()[0], 0);
+
+  // Big enough for a huge page
+  AlignedBuffer<double> big{AlignedBuffer<double>::hugePageSize, true};
+  BOOST_CHECK(big.hugePages());
+  BOOST_CHECK(isAligned(big.data(), AlignedBuffer<double>::hugePageSize));
+}
+
+BOOST_AUTO_TEST_CASE(Resize_test) {
+  AlignedBuffer<std::string> buffer{2};
+  buffer.data()[0] = "a";
+  buffer.data()[1] = "b";
+
+  buffer.resize(5);
+  BOOST_CHECK_EQUAL(buffer.size(), 5);
+  BOOST_CHECK_EQUAL(buffer.data()[1], "b");
+  BOOST_CHECK(buffer.data()[4].empty());
+
+  auto copy = buffer;
+  copy.resize(1);
+  BOOST_CHECK_EQUAL(copy.data()[0], "a");
+  BOOST_CHECK_EQUAL(buffer.size(), 5);
+
+  AlignedBuffer<std::string> moved{std::move(buffer)};
+  BOOST_CHECK_EQUAL(moved.size(), 5);
+  BOOST_CHECK_EQUAL(buffer.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Capacity_test) {
+  AlignedBuffer<int> buffer{4};
+  buffer.reserve(100);
+  BOOST_CHECK_EQUAL(buffer.capacity(), 100);
+  const int *data = buffer.data();
+  buffer.resize(50);
+  BOOST_CHECK_EQUAL(buffer.data(), data);
+  BOOST_CHECK_EQUAL(buffer.data()[49], 0);
+
+  buffer.shrink_to_fit();
+  BOOST_CHECK_EQUAL(buffer.capacity(), 50);
+  BOOST_CHECK(isAligned(buffer.data(), AlignedBuffer<int>::alignment));
+}
+
+BOOST_AUTO_TEST_CASE(NdArray_test) {
+  auto array = createAligned<float>({10, 3}, true);
+  BOOST_CHECK(isAligned(array.data(), AlignedBuffer<float>::alignment));
+  std::iota(array.begin(), array.end(), 0.f);
+
+  // Copies use the same kind of storage
+  auto copy = array.copy();
+  BOOST_CHECK(isAligned(copy.data(), AlignedBuffer<float>::alignment));
+  BOOST_CHECK(copy == array);
+
+  // Concatenation resizes the buffer
+  array.concatenate(copy);
+  BOOST_CHECK_EQUAL(array.shape()[0], 20);
+  BOOST_CHECK(isAligned(array.data(), AlignedBuffer<float>::alignment));
+  BOOST_CHECK_EQUAL(array.at(19, 2), 29.f);
+
+  BOOST_CHECK_THROW(NdArray<float>({4}, AlignedBuffer<float>(3)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <cmath>
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+#include <ElementsKernel/Temporary.h>
+#include "NdArray/io/Chunked.h"
+
+using namespace Euclid::NdArray;
+using Euclid::ThreadPool;
+
+struct Chunked_Fixture {
+  Elements::TempFile file{"chunked_%%%%.ndc"};
+  ThreadPool pool{4};
+  NdArray<double> grid{{30, 40, 50}};
+
+  Chunked_Fixture() {
+    size_t i = 0;
+    for (auto& v : grid) {
+      v = std::sin(i++ * 1e-3);
+    }
+  }
+};
+
+BOOST_AUTO_TEST_SUITE(Chunked_test)
+
+BOOST_FIXTURE_TEST_CASE(Roundtrip_test, Chunked_Fixture) {
+  for (auto codec : {ChunkCodec::NONE, ChunkCodec::ZLIB}) {
+    writeChunked(file.path(), grid, {7, 16, 50}, codec, pool);
+
+    ChunkedReader reader(file.path());
+    BOOST_CHECK(reader.shape() == grid.shape());
+    std::vector<size_t> expected_chunk{7, 16, 50};
+    BOOST_CHECK(reader.chunkShape() == expected_chunk);
+    BOOST_CHECK(reader.codec() == codec);
+    BOOST_CHECK(reader.read<double>(pool) == grid);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(Compression_test, Chunked_Fixture) {
+  // Quantized, so only the most significant bytes change
+  for (auto& v : grid) {
+    v = std::round(v * 100);
+  }
+  writeChunked(file.path(), grid, {10, 10, 10}, ChunkCodec::ZLIB, pool);
+  BOOST_CHECK_LT(boost::filesystem::file_size(file.path()), grid.size() * sizeof(double) / 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(Region_test, Chunked_Fixture) {
+  writeChunked(file.path(), grid, {8, 8, 8}, ChunkCodec::ZLIB, pool);
+  ChunkedReader reader(file.path());
+
+  auto region = reader.read<double>({5, 13, 40}, {20, 3, 10}, pool);
+  std::vector<size_t> expected_shape{20, 3, 10};
+  BOOST_CHECK(region.shape() == expected_shape);
+  for (size_t i = 0; i < 20; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      for (size_t k = 0; k < 10; ++k) {
+        BOOST_CHECK_EQUAL(region.at(i, j, k), grid.at(5 + i, 13 + j, 40 + k));
+      }
+    }
+  }
+
+  BOOST_CHECK_THROW(reader.read<double>({25, 0, 0}, {10, 1, 1}), std::out_of_range);
+  BOOST_CHECK_THROW(reader.read<double>({0, 0}, {1, 1}), std::out_of_range);
+  BOOST_CHECK_THROW(reader.read<float>(), Elements::Exception);
+}
+
+BOOST_FIXTURE_TEST_CASE(OnlyOverlapping_test, Chunked_Fixture) {
+  writeChunked(file.path(), grid, {15, 40, 50}, ChunkCodec::ZLIB, pool);
+
+  // Corrupt the end of the second, and last, chunk
+  {
+    std::fstream stream(file.path().native(), std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(-64, std::ios::end);
+    stream.write(std::string(64, '\xff').data(), 64);
+  }
+
+  ChunkedReader reader(file.path());
+  auto first = reader.read<double>({0, 0, 0}, {15, 40, 50}, pool);
+  BOOST_CHECK_EQUAL(first.at(14, 39, 49), grid.at(14, 39, 49));
+  BOOST_CHECK_THROW(reader.read<double>(pool), Elements::Exception);
+}
+
+BOOST_FIXTURE_TEST_CASE(View_test, Chunked_Fixture) {
+  auto transposed = grid.transpose();
+  writeChunked(file.path(), transposed, {9, 9, 9}, ChunkCodec::ZLIB, pool);
+  BOOST_CHECK(ChunkedReader(file.path()).read<double>(pool) == transposed);
+}
+
+BOOST_FIXTURE_TEST_CASE(Attributes_test, Chunked_Fixture) {
+  NdArray<float> table{{100}, std::vector<std::string>{"x", "y", "z"}};
+  std::iota(table.begin(), table.end(), 0.f);
+  writeChunked(file.path(), table, {32, 3}, ChunkCodec::ZLIB, pool);
+
+  ChunkedReader reader(file.path());
+  auto all = reader.read<float>(pool);
+  BOOST_CHECK(all.attributes() == table.attributes());
+  BOOST_CHECK(all == table);
+
+  auto yz = reader.read<float>({50, 1}, {10, 2}, pool);
+  std::vector<std::string> expected_attrs{"y", "z"};
+  BOOST_CHECK(yz.attributes() == expected_attrs);
+  BOOST_CHECK_EQUAL(yz.at(0, "y"), table.at(50, "y"));
+  BOOST_CHECK_EQUAL(yz.at(9, "z"), table.at(59, "z"));
+}
+
+BOOST_FIXTURE_TEST_CASE(BadChunks_test, Chunked_Fixture) {
+  BOOST_CHECK_THROW(writeChunked(file.path(), grid, {10, 10}), std::invalid_argument);
+  BOOST_CHECK_THROW(writeChunked(file.path(), grid, {10, 0, 10}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
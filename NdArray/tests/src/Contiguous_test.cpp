@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+* @file tests/src/Contiguous_test.cpp
+* @author Alejandro Alvarez Ayllon
+*/
+
+#include <boost/test/unit_test.hpp>
+#include "NdArray/Contiguous.h"
+
+using namespace Euclid::NdArray;
+using Euclid::ThreadPool;
+
+BOOST_AUTO_TEST_SUITE(Contiguous_test)
+
+BOOST_AUTO_TEST_CASE(AlreadyContiguous_test) {
+  NdArray<int> array{4, 5};
+  auto same = asContiguous(array);
+  BOOST_CHECK_EQUAL(same.data(), array.data());
+}
+
+BOOST_AUTO_TEST_CASE(Transpose_test) {
+  NdArray<int> array{37, 70};
+  std::iota(array.begin(), array.end(), 0);
+
+  auto transposed = array.transpose();
+  auto contiguous = asContiguous(transposed);
+  BOOST_CHECK(contiguous.isContiguous());
+  BOOST_CHECK(contiguous == transposed);
+}
+
+BOOST_AUTO_TEST_CASE(Strided_test) {
+  NdArray<double> array{6, 7, 8};
+  std::iota(array.begin(), array.end(), 0.);
+
+  // The innermost axis of the input is not the last one of the output
+  auto view = array.transpose({2, 0, 1}).slice({Slice(1, 7, 2)});
+  BOOST_CHECK(asContiguous(view) == view);
+
+  // Only strided along the last axis
+  auto columns = array.slice({Slice(), Slice(), Slice(0, 8, 3)});
+  BOOST_CHECK(asContiguous(columns) == columns);
+}
+
+BOOST_AUTO_TEST_CASE(Attributes_test) {
+  NdArray<float> named{{10, 20}, std::vector<std::string>{"A", "B", "C"}};
+  std::iota(named.begin(), named.end(), 0.f);
+
+  auto view = named.transpose({1, 0, 2});
+  auto contiguous = asContiguous(view);
+  BOOST_CHECK(contiguous.attributes() == named.attributes());
+  BOOST_CHECK_EQUAL(contiguous.at(3, 2, "B"), named.at(2, 3, "B"));
+  BOOST_CHECK(contiguous == view);
+}
+
+BOOST_AUTO_TEST_CASE(Parallel_test) {
+  ThreadPool pool{4};
+  NdArray<int64_t> array{300, 400};
+  std::iota(array.begin(), array.end(), 0);
+
+  auto transposed = array.transpose();
+  BOOST_CHECK(asContiguous(transposed, pool) == transposed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -182,7 +182,7 @@ BOOST_AUTO_TEST_CASE(Concatenate_test) {
   BOOST_CHECK_EQUAL(m.shape()[1], 3);
 
   std::vector<int> expected = values1;
-  std::copy(values2.begin(), values2.end(), std::back_inserter(values1));
+  std::copy(values2.begin(), values2.end(), std::back_inserter(expected));
 
   BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), m.begin(), m.end());
 }
@@ -215,4 +215,265 @@ BOOST_AUTO_TEST_CASE(AttrNames_test) {
   BOOST_CHECK_EQUAL_COLLECTIONS(attrs.begin(), attrs.end(), attr_names.begin(), attr_names.end());
 }
 
+BOOST_AUTO_TEST_CASE(VariadicOffset_test) {
+  NdArray<int> m{3, 4, 5};
+  std::iota(m.begin(), m.end(), 0);
+  NdArray<int> named{{4}, std::vector<std::string>{"X", "Y"}};
+  std::iota(named.begin(), named.end(), 0);
+
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      for (size_t k = 0; k < 5; ++k) {
+        BOOST_CHECK_EQUAL(m.at(i, j, k), (m.at(std::vector<size_t>{i, j, k})));
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(named.at(2, "Y"), 5);
+  BOOST_CHECK_THROW(named.at(2, "Z"), std::out_of_range);
+  BOOST_CHECK_THROW(named.at(4, "X"), std::out_of_range);
+  BOOST_CHECK_THROW(named.at(1, 1, "X"), std::out_of_range);
+  BOOST_CHECK_THROW(m.at(2, 3, 5), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(Slice_test) {
+  NdArray<int> m{4, 6};
+  std::iota(m.begin(), m.end(), 0);
+
+  auto view = m.slice({Slice(1, 4, 2), Slice(1, Slice::END, 3)});
+  BOOST_CHECK_EQUAL(view.shape().size(), 2);
+  BOOST_CHECK_EQUAL(view.shape()[0], 2);
+  BOOST_CHECK_EQUAL(view.shape()[1], 2);
+  std::vector<int> expected{7, 10, 19, 22};
+  BOOST_CHECK_EQUAL_COLLECTIONS(view.begin(), view.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(view.at(1, 0), 19);
+
+  // The data is shared
+  view.at(1, 1) = -1;
+  BOOST_CHECK_EQUAL(m.at(3, 4), -1);
+
+  // Empty ranges, and bad ranges
+  BOOST_CHECK_EQUAL(m.slice(0, Slice(2, 2)).size(), 0);
+  BOOST_CHECK_THROW(m.slice(0, Slice(5)), std::out_of_range);
+  BOOST_CHECK_THROW(m.slice(2, Slice(0)), std::out_of_range);
+  BOOST_CHECK_THROW(m.slice(0, Slice(0, 2, 0)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Select_test) {
+  NdArray<int> m{3, 4, 5};
+  std::iota(m.begin(), m.end(), 0);
+
+  auto plane = m.select(1, 2);
+  BOOST_CHECK_EQUAL(plane.shape().size(), 2);
+  BOOST_CHECK_EQUAL(plane.shape()[0], 3);
+  BOOST_CHECK_EQUAL(plane.shape()[1], 5);
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t k = 0; k < 5; ++k) {
+      BOOST_CHECK_EQUAL(plane.at(i, k), m.at(i, 2, k));
+    }
+  }
+
+  auto column = m.select(0, 1).select(1, 3);
+  std::vector<int> expected{23, 28, 33, 38};
+  BOOST_CHECK_EQUAL_COLLECTIONS(column.begin(), column.end(), expected.begin(), expected.end());
+  BOOST_CHECK_THROW(m.select(1, 4), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(Transpose_test) {
+  NdArray<int> m{2, 3};
+  std::iota(m.begin(), m.end(), 0);
+
+  auto t = m.transpose();
+  BOOST_CHECK_EQUAL(t.shape()[0], 3);
+  BOOST_CHECK_EQUAL(t.shape()[1], 2);
+  std::vector<int> expected{0, 3, 1, 4, 2, 5};
+  BOOST_CHECK_EQUAL_COLLECTIONS(t.begin(), t.end(), expected.begin(), expected.end());
+  BOOST_CHECK(t.transpose() == m);
+  BOOST_CHECK_THROW(t.reshape(6), std::invalid_argument);
+  BOOST_CHECK_THROW(m.transpose({0, 0}), std::invalid_argument);
+
+  NdArray<int> named{{4}, std::vector<std::string>{"X", "Y"}};
+  BOOST_CHECK_THROW(named.transpose(), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(IteratorLifetime_test) {
+  NdArray<int> m{3, 4};
+  std::iota(m.begin(), m.end(), 0);
+
+  // The iterators depend on the data, not on the NdArray that created them
+  auto view_begin = m.slice(1, Slice(1, 4, 2)).begin();
+  auto view_end = m.slice(1, Slice(1, 4, 2)).end();
+  std::vector<int> expected{1, 3, 5, 7, 9, 11};
+  BOOST_CHECK_EQUAL_COLLECTIONS(view_begin, view_end, expected.begin(), expected.end());
+
+  std::vector<NdArray<int>> views;
+  views.emplace_back(m.transpose());
+  auto t_begin = views.front().begin();
+  for (int i = 0; i < 10; ++i) {
+    views.emplace_back(m);
+  }
+  BOOST_CHECK_EQUAL(*(t_begin + 1), 4);
+
+  // Nor do they follow the NdArray if it is reassigned
+  auto t = m.transpose();
+  auto t_it = t.begin() + 1;
+  t = m;
+  BOOST_CHECK_EQUAL(*t_it, 4);
+}
+
+BOOST_AUTO_TEST_CASE(Squeeze_test) {
+  NdArray<int> m{1, 3, 1, 2};
+  std::iota(m.begin(), m.end(), 0);
+
+  auto squeezed = m.squeeze();
+  BOOST_CHECK_EQUAL(squeezed.shape().size(), 2);
+  BOOST_CHECK_EQUAL(squeezed.shape()[0], 3);
+  BOOST_CHECK_EQUAL(squeezed.shape()[1], 2);
+  BOOST_CHECK_EQUAL_COLLECTIONS(squeezed.begin(), squeezed.end(), m.begin(), m.end());
+  // Still contiguous, so it can be reshaped
+  squeezed.reshape(6);
+}
+
+BOOST_AUTO_TEST_CASE(ViewAttributes_test) {
+  NdArray<int> named{{4}, std::vector<std::string>{"X", "Y", "Z"}};
+  std::iota(named.begin(), named.end(), 0);
+
+  auto view = named.slice(1, Slice(1));
+  std::vector<std::string> expected{"Y", "Z"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(view.attributes().begin(), view.attributes().end(),
+                                expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(view.at(2, "Z"), 8);
+  BOOST_CHECK(named.select(1, 0).attributes().empty());
+}
+
+BOOST_AUTO_TEST_CASE(ViewCopy_test) {
+  NdArray<int> m{4, 4};
+  std::iota(m.begin(), m.end(), 0);
+
+  auto view = m.slice({Slice(1, 3), Slice(2)});
+  auto copy = view.copy();
+  copy.at(0, 0) = -1;
+  BOOST_CHECK_EQUAL(m.at(1, 2), 6);
+  BOOST_CHECK(copy.slice(0, Slice(1)) == view.slice(0, Slice(1)));
+  // The copy is a regular array again
+  copy.reshape(4);
+  BOOST_CHECK_THROW(view.concatenate(view), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Data_test) {
+  NdArray<int> m{4, 3};
+  std::iota(m.begin(), m.end(), 0);
+
+  BOOST_CHECK(m.isContiguous());
+  std::vector<size_t> expected_strides{3, 1};
+  BOOST_CHECK(m.strides() == expected_strides);
+  m.data()[4] = -4;
+  BOOST_CHECK_EQUAL(m.at(1, 1), -4);
+
+  // Slicing the first axis keeps the memory contiguous
+  auto rows = m.slice(0, Slice(1, 3));
+  BOOST_CHECK(rows.isContiguous());
+  BOOST_CHECK_EQUAL(rows.data(), m.data() + 3);
+  auto span = rows.span();
+  BOOST_CHECK_EQUAL(span.size(), 6);
+  BOOST_CHECK_EQUAL_COLLECTIONS(span.begin(), span.end(), rows.begin(), rows.end());
+
+  const NdArray<int>& const_m = m;
+  Span<const int> const_span = const_m.span();
+  BOOST_CHECK_EQUAL(const_span[4], -4);
+
+  // Columns and transpositions do not
+  auto columns = m.slice(1, Slice(0, 2));
+  BOOST_CHECK(!columns.isContiguous());
+  BOOST_CHECK_THROW(columns.data(), std::invalid_argument);
+  BOOST_CHECK_THROW(m.transpose().span(), std::invalid_argument);
+  // Unless they only keep one column
+  BOOST_CHECK(m.slice(0, Slice(2, 3)).transpose().isContiguous());
+}
+
+BOOST_AUTO_TEST_CASE(Append_test) {
+  NdArray<int> array{0, 3};
+  NdArray<int> entry{3};
+
+  size_t reallocations = 0;
+  const int *data = nullptr;
+  for (int i = 0; i < 1000; ++i) {
+    std::fill(entry.begin(), entry.end(), i);
+    array.append(entry);
+    if (array.data() != data) {
+      data = array.data();
+      ++reallocations;
+    }
+  }
+  BOOST_CHECK_EQUAL(array.shape()[0], 1000);
+  BOOST_CHECK_LT(reallocations, 20);
+  BOOST_CHECK_GE(array.capacity(), 1000);
+  BOOST_CHECK_EQUAL(array.at(999, 2), 999);
+  BOOST_CHECK_EQUAL(array.at(500, 0), 500);
+
+  array.shrinkToFit();
+  BOOST_CHECK_EQUAL(array.capacity(), 1000);
+
+  // Appending more than one entry
+  array.append(array.slice(0, Slice(0, 2)).copy());
+  BOOST_CHECK_EQUAL(array.shape()[0], 1002);
+  BOOST_CHECK_EQUAL(array.at(1001, 1), 1);
+
+  BOOST_CHECK_THROW(array.append(NdArray<int>{2}), std::length_error);
+  BOOST_CHECK_THROW(array.slice(0, Slice(1)).append(entry), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Reserve_test) {
+  NdArray<float> array{2, 4};
+  array.reserve(100);
+  BOOST_CHECK_EQUAL(array.capacity(), 100);
+
+  // concatenate does not reallocate within the capacity
+  const float *data = array.data();
+  NdArray<float> other{10, 4};
+  for (size_t i = 0; i < 9; ++i) {
+    array.concatenate(other);
+  }
+  BOOST_CHECK_EQUAL(array.data(), data);
+  BOOST_CHECK_EQUAL(array.shape()[0], 92);
+  BOOST_CHECK_THROW(array.transpose().reserve(200), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(AttributeHandle_test) {
+  NdArray<int> named{{5}, std::vector<std::string>{"X", "Y", "Z"}};
+  std::iota(named.begin(), named.end(), 0);
+
+  auto y = named.attribute("Y");
+  BOOST_CHECK_EQUAL(y.index, 1);
+  BOOST_CHECK_EQUAL(named.at(2, y), named.at(2, "Y"));
+  BOOST_CHECK_EQUAL(named.at(std::vector<size_t>{4}, y), 13);
+  named.at(0, y) = -1;
+  BOOST_CHECK_EQUAL(named.at(std::vector<size_t>{0}, "Y"), -1);
+
+  BOOST_CHECK_THROW(named.attribute("W"), std::out_of_range);
+  BOOST_CHECK_THROW(named.at(5, y), std::out_of_range);
+  BOOST_CHECK_THROW(named.at(0, AttributeHandle(3)), std::out_of_range);
+  BOOST_CHECK_THROW(named.at(std::vector<size_t>{0, 1}, y), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(Field_test) {
+  NdArray<int> named{{4}, std::vector<std::string>{"X", "Y"}};
+  std::iota(named.begin(), named.end(), 0);
+
+  auto x = named.field("X");
+  std::vector<size_t> expected_shape{4}, expected_strides{2};
+  BOOST_CHECK(x.shape() == expected_shape);
+  BOOST_CHECK(x.strides() == expected_strides);
+  BOOST_CHECK(x.attributes().empty());
+  std::vector<int> expected{0, 2, 4, 6};
+  BOOST_CHECK_EQUAL_COLLECTIONS(x.begin(), x.end(), expected.begin(), expected.end());
+
+  // The view shares the data
+  auto y = named.field(named.attribute("Y"));
+  std::fill(y.begin(), y.end(), 0);
+  BOOST_CHECK_EQUAL(named.at(3, "Y"), 0);
+  BOOST_CHECK_EQUAL(named.at(3, "X"), 6);
+
+  BOOST_CHECK_THROW(named.field("Z"), std::out_of_range);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -150,6 +150,98 @@ BOOST_AUTO_TEST_CASE(MmapAppend_NotEnough_test) {
   BOOST_CHECK_THROW(ndarray.concatenate(another), Elements::Exception);
 }
 
+BOOST_AUTO_TEST_CASE(MmapAppendOldHeader_test) {
+  Elements::TempFile file("npy_old_header_mmap_%%.npy");
+
+  // Older versions padded the header to 130 bytes
+  {
+    std::string dict = "{'descr': '<i4', 'fortran_order': False, 'shape': (10, 2), }";
+    dict.append(130 - 12 - dict.size() - 1, ' ');
+    dict.push_back('\n');
+    boost::endian::little_uint32_t header_len = dict.size();
+    std::ofstream out(file.path().native(), std::ios::binary);
+    out.write("\x93NUMPY\x02\x00", 8);
+    out.write(reinterpret_cast<const char*>(&header_len), sizeof(header_len));
+    out.write(dict.data(), dict.size());
+    std::vector<int32_t> data(20);
+    std::iota(data.begin(), data.end(), 0);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(int32_t));
+  }
+
+  auto ndarray = mmapNpy<int32_t>(file.path(), boost::iostreams::mapped_file_base::readwrite, 4096);
+  BOOST_CHECK_EQUAL(ndarray.at(9, 1), 19);
+
+  NdArray<int32_t> another({5, 2});
+  std::fill(another.begin(), another.end(), 42);
+  ndarray.concatenate(another);
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(file.path()), 130 + 30 * sizeof(int32_t));
+
+  constexpr const char* PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.load(sys.argv[1])
+assert a.shape == (15, 2), a.shape
+assert (a[:10].ravel() == np.arange(20)).all()
+assert (a[10:] == 42).all()
+)EDOCYP";
+  runPython(PYCODE, file.path());
+}
+
+BOOST_AUTO_TEST_CASE(MmapAppendGrow_test) {
+  Elements::TempFile file("npy_grow_mmap_%%.npy");
+
+  // No space is reserved, but append remaps the file as needed
+  auto ndarray = createMmapNpy<int32_t>(file.path(), {1, 2});
+  NdArray<int32_t> entry({2});
+  for (int32_t i = 1; i < 500; ++i) {
+    entry.at(0) = i;
+    entry.at(1) = -i;
+    ndarray.append(entry);
+  }
+  BOOST_CHECK_GE(ndarray.capacity(), 500);
+  ndarray.shrinkToFit();
+  BOOST_CHECK_EQUAL(ndarray.capacity(), 500);
+
+  constexpr const char* PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.load(sys.argv[1])
+assert a.shape == (500, 2), a.shape
+assert (a[1:, 0] == np.arange(1, 500)).all()
+assert (a[1:, 1] == -np.arange(1, 500)).all()
+)EDOCYP";
+  runPython(PYCODE, file.path());
+}
+
+BOOST_AUTO_TEST_CASE(MmapFortran_test) {
+  Elements::TempFile file("npy_fortran_mmap_%%.npy");
+
+  constexpr const char* PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+np.save(sys.argv[1], np.asfortranarray(np.arange(12, dtype=np.float64).reshape(3, 4)))
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  {
+    auto ndarray = mmapNpy<double>(file.path());
+    std::vector<size_t> expected_shape{3, 4};
+    BOOST_CHECK(ndarray.shape() == expected_shape);
+    BOOST_CHECK_EQUAL(ndarray.at(1, 2), 6.);
+    BOOST_CHECK_EQUAL(ndarray.at(2, 0), 8.);
+    ndarray.at(2, 3) = -1.;
+  }
+
+  constexpr const char* PYCODE2 = R"EDOCYP(
+import sys
+import numpy as np
+a = np.load(sys.argv[1])
+assert a[2, 3] == -1., a
+assert a[1, 2] == 6., a
+)EDOCYP";
+  runPython(PYCODE2, file.path());
+}
+
 BOOST_AUTO_TEST_CASE(MmapNamed_test) {
   Elements::TempFile file("npy_named_mmap_%%.npy");
   const std::vector<std::string> attr_names{"ID", "SED", "PDZ"};
@@ -265,4 +357,61 @@ assert np.allclose(a[100:]['Y'], 4.2)
   runPython(PYCODE, file.path());
 }
 
+BOOST_AUTO_TEST_CASE(MmapView_test) {
+  Elements::TempFile file("npy_mmap_%%.npy");
+
+  NdArray<int32_t> ndarray({50, 10, 40});
+  std::generate(ndarray.begin(), ndarray.end(), []() { return std::rand() % 1024; });
+  writeNpy(file.path(), ndarray);
+
+  // Modify a sub-block through a view
+  {
+    auto mmapped = mmapNpy<int32_t>(file.path());
+    auto block = mmapped.slice({Slice(10, 20), Slice(), Slice(0, 40, 4)}).transpose();
+    BOOST_CHECK_EQUAL(block.shape()[0], 10);
+    BOOST_CHECK_EQUAL(block.shape()[1], 10);
+    BOOST_CHECK_EQUAL(block.shape()[2], 10);
+    block.at(3, 2, 1) = 1024 + 42;
+  }
+
+  auto read = readNpy<int32_t>(file.path());
+  BOOST_CHECK_EQUAL(read.at(11, 2, 12), 1024 + 42);
+}
+
+BOOST_AUTO_TEST_CASE(MmapAdvice_test) {
+  Elements::TempFile file("npy_mmap_advice_%%.npy");
+
+  {
+    auto created = createMmapNpy<int32_t>(file.path(), {2000, 1000});
+    std::iota(created.begin(), created.end(), 0);
+  }
+
+  auto mmapped = mmapNpy<int32_t>(file.path(), boost::iostreams::mapped_file_base::priv);
+  adviseAccess(mmapped, MmapAccess::SEQUENTIAL);
+  prefetch(mmapped, 0, 500);
+  mmapped.at(10, 10) = -1;
+
+  // The content is kept, including the changes to a copy-on-write mapping
+  evict(mmapped, 0, 1000);
+  BOOST_CHECK_EQUAL(mmapped.at(10, 10), -1);
+  BOOST_CHECK_EQUAL(mmapped.at(999, 999), 999999);
+  BOOST_CHECK_EQUAL(mmapped.at(1999, 999), 1999999);
+
+  // Views are supported too
+  auto transposed = mmapped.transpose();
+  adviseAccess(transposed, MmapAccess::RANDOM);
+  prefetch(transposed, 100, 10);
+  evict(transposed, 0, 1000);
+  BOOST_CHECK_EQUAL(transposed.at(10, 10), -1);
+
+  const auto readonly = mmapNpy<int32_t>(file.path(), boost::iostreams::mapped_file_base::readonly);
+  adviseAccess(readonly, MmapAccess::SEQUENTIAL);
+  BOOST_CHECK_EQUAL(std::accumulate(readonly.begin(), readonly.end(), int64_t(0)), int64_t(1999999) * 1000000);
+  evict(readonly, 0, 2000);
+  BOOST_CHECK_EQUAL(readonly.at(10, 10), 10010);
+
+  BOOST_CHECK_THROW(prefetch(mmapped, 1500, 501), std::out_of_range);
+  BOOST_CHECK_THROW(evict(mmapped, 2001, 0), std::out_of_range);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
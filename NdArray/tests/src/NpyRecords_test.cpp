@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <numeric>
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+#include <ElementsKernel/Temporary.h>
+#include "NdArray/io/NpyRecords.h"
+#include "TestHelper.h"
+
+using namespace Euclid::NdArray;
+
+BOOST_AUTO_TEST_SUITE(NpyRecords_test)
+
+BOOST_AUTO_TEST_CASE(ReadFromPython_test) {
+  Elements::TempFile file("npy_records_%%.npy");
+
+  // A field named as a key of the header must not confuse the parser
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.zeros((3, 4), dtype=[('shape', '<i8'), ('flux', '<f4'), ('flag', 'u1'), ('err', '>f8')])
+a['shape'] = np.arange(12).reshape(3, 4)
+a['flux'] = np.arange(12).reshape(3, 4) * 0.5
+a['flag'] = 7
+a['err'] = -np.arange(12).reshape(3, 4)
+np.save(sys.argv[1], a)
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  auto records = readNpyRecords(file.path());
+  std::vector<size_t> expected_shape{3, 4};
+  std::vector<std::string> expected_fields{"shape", "flux", "flag", "err"};
+  BOOST_CHECK(records.shape() == expected_shape);
+  BOOST_CHECK(records.fields() == expected_fields);
+
+  auto shape = records.field<int64_t>("shape");
+  auto flux = records.field<float>("flux");
+  auto flag = records.field<uint8_t>("flag");
+  auto err = records.field<double>("err");
+  BOOST_CHECK(flux.isContiguous());
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      BOOST_CHECK_EQUAL(shape.at(i, j), i * 4 + j);
+      BOOST_CHECK_EQUAL(flux.at(i, j), (i * 4 + j) * 0.5f);
+      BOOST_CHECK_EQUAL(flag.at(i, j), 7);
+      BOOST_CHECK_EQUAL(err.at(i, j), -double(i * 4 + j));
+    }
+  }
+  BOOST_CHECK_THROW(records.field<double>("flux"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(WriteToPython_test) {
+  Elements::TempFile file("npy_records_%%.npy");
+
+  RecordArray records({100});
+  NdArray<int32_t> id({100});
+  std::iota(id.begin(), id.end(), 0);
+  NdArray<double> table{{100}, std::vector<std::string>{"ra", "dec"}};
+  std::iota(table.begin(), table.end(), 0.);
+  records.addField("id", id);
+  records.addField("dec", table.field("dec"));
+  writeNpy(file.path(), records);
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.load(sys.argv[1])
+assert a.shape == (100,)
+assert a.dtype.names == ('id', 'dec')
+assert a.dtype['id'] == np.int32
+print((a['id'] * a['dec']).sum())
+)EDOCYP";
+  auto output = runPython(PYCODE, file.path());
+
+  double expected = 0, sum;
+  for (size_t i = 0; i < 100; ++i) {
+    expected += i * table.at(i, "dec");
+  }
+  output >> sum;
+  BOOST_CHECK_EQUAL(sum, expected);
+}
+
+BOOST_AUTO_TEST_CASE(Roundtrip_test) {
+  std::stringstream stream;
+
+  RecordArray records({20, 3});
+  NdArray<uint16_t> a({20, 3});
+  NdArray<float> b({20, 3});
+  std::iota(a.begin(), a.end(), 0);
+  std::iota(b.begin(), b.end(), 0.25f);
+  records.addField("a", a);
+  records.addField("b", b.transpose().transpose());
+  writeNpy(stream, records);
+
+  auto read = readNpyRecords(stream);
+  BOOST_CHECK(read.fields() == records.fields());
+  BOOST_CHECK(read.field<uint16_t>("a") == a);
+  BOOST_CHECK(read.field<float>("b") == b);
+}
+
+BOOST_AUTO_TEST_CASE(Errors_test) {
+  std::stringstream stream;
+  BOOST_CHECK_THROW(writeNpy(stream, RecordArray({10})), Elements::Exception);
+
+  RecordArray records({10});
+  records.addField("c", NdArray<char>({10}));
+  BOOST_CHECK_THROW(writeNpy(stream, records), Elements::Exception);
+
+  // Not a structured array
+  std::stringstream plain;
+  writeNpy(plain, NdArray<float>({10}));
+  BOOST_CHECK_THROW(readNpyRecords(plain), Elements::Exception);
+}
+
+BOOST_AUTO_TEST_CASE(Mmap_test) {
+  Elements::TempFile file("npy_records_%%.npy");
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.zeros((50,), dtype=[('id', '<i8'), ('flux', '<f8'), ('err', '>f8')])
+a['id'] = np.arange(50)
+a['flux'] = np.arange(50) * 2.
+a['err'] = 1.5
+np.save(sys.argv[1], a)
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  {
+    auto records = mmapNpyRecords(file.path());
+    auto flux = records.field<double>("flux");
+    // Mapped as a strided view of the records
+    BOOST_CHECK(!flux.isContiguous());
+    BOOST_CHECK_EQUAL(records.field<int64_t>("id").at(10), 10);
+    BOOST_CHECK_EQUAL(flux.at(10), 20.);
+    // Big endian, so it is copied
+    BOOST_CHECK(records.field<double>("err").isContiguous());
+    BOOST_CHECK_EQUAL(records.field<double>("err").at(3), 1.5);
+
+    flux.at(7) = -1.;
+    BOOST_CHECK_EQUAL(records.field<double>("flux").at(7), -1.);
+  }
+
+  constexpr const char *PYCHECK = R"EDOCYP(
+import sys
+import numpy as np
+a = np.load(sys.argv[1])
+print(a['flux'][7], a['id'][7])
+)EDOCYP";
+  auto output = runPython(PYCHECK, file.path());
+  double flux;
+  int64_t id;
+  output >> flux >> id;
+  BOOST_CHECK_EQUAL(flux, -1.);
+  BOOST_CHECK_EQUAL(id, 7);
+}
+
+BOOST_AUTO_TEST_CASE(MmapUnaligned_test) {
+  Elements::TempFile file("npy_records_%%.npy");
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.zeros((2, 30), dtype=[('flag', 'u1'), ('value', '<f4')])
+a['flag'] = 1
+a['value'] = np.arange(60).reshape(2, 30)
+np.save(sys.argv[1], np.asfortranarray(a))
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  auto records = mmapNpyRecords(file.path(), boost::iostreams::mapped_file_base::readonly);
+  std::vector<size_t> expected_shape{2, 30};
+  BOOST_CHECK(records.shape() == expected_shape);
+  auto value = records.field<float>("value");
+  BOOST_CHECK_EQUAL(value.at(1, 3), 33.f);
+  BOOST_CHECK_EQUAL(records.field<uint8_t>("flag").at(1, 29), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
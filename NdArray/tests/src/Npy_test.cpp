@@ -172,6 +172,102 @@ np.save(sys.argv[1], np.arange(100, 400, dtype='>i8'))
   BOOST_CHECK_THROW(readNpy<int64_t>(file.path()), Elements::Exception);
 }
 
+BOOST_AUTO_TEST_CASE(Npy_convert_test) {
+  std::stringstream stream;
+
+  NdArray<float> ndarray({3, 4});
+  std::iota(ndarray.begin(), ndarray.end(), 0.5f);
+  writeNpy(stream, ndarray);
+
+  auto rend = readNpy<double>(stream, NpyReadMode::CONVERT);
+  BOOST_CHECK(rend.shape() == ndarray.shape());
+  BOOST_CHECK_EQUAL_COLLECTIONS(ndarray.begin(), ndarray.end(), rend.begin(), rend.end());
+}
+
+BOOST_AUTO_TEST_CASE(Npy_convert_endian_test) {
+  Elements::TempFile file(std::string("npy_testpy_convert_endian_%%.npy"));
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+np.save(sys.argv[1], np.arange(-100, 200000, dtype='>i4'))
+)EDOCYP";
+
+  runPython(PYCODE, file.path());
+
+  // Same type, only swapped
+  auto same = readNpy<int32_t>(file.path(), NpyReadMode::CONVERT);
+  // Swapped and converted, over several chunks
+  auto converted = readNpy<double>(file.path(), NpyReadMode::CONVERT);
+
+  BOOST_CHECK_EQUAL(same.size(), 200100);
+  BOOST_CHECK_EQUAL(converted.size(), 200100);
+  for (size_t i = 0; i < same.size(); ++i) {
+    BOOST_CHECK_EQUAL(same.at(i), static_cast<int32_t>(i) - 100);
+    BOOST_CHECK_EQUAL(converted.at(i), static_cast<double>(i) - 100);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Npy_convert_attrs_test) {
+  Elements::TempFile file(std::string("npy_testpy_convert_attrs_%%.npy"));
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.array([(1, 2), (3, 4)], dtype=[('a', '>u2'), ('b', '>u2')])
+np.save(sys.argv[1], a)
+)EDOCYP";
+
+  runPython(PYCODE, file.path());
+
+  auto ndarray = readNpy<float>(file.path(), NpyReadMode::CONVERT);
+  BOOST_CHECK_EQUAL(ndarray.at(1, "a"), 3.f);
+  BOOST_CHECK_EQUAL(ndarray.at(1, "b"), 4.f);
+}
+
+BOOST_AUTO_TEST_CASE(Npy_fortran_read_test) {
+  Elements::TempFile file(std::string("npy_testpy_fortran_%%.npy"));
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+np.save(sys.argv[1], np.asfortranarray(np.arange(24, dtype=np.int64).reshape(2, 3, 4)))
+)EDOCYP";
+
+  runPython(PYCODE, file.path());
+
+  auto ndarray = readNpy<int64_t>(file.path());
+  std::vector<size_t> expected_shape{2, 3, 4};
+  BOOST_CHECK(ndarray.shape() == expected_shape);
+  BOOST_CHECK(!ndarray.isContiguous());
+  for (size_t i = 0; i < 24; ++i) {
+    BOOST_CHECK_EQUAL(ndarray.at(i / 12, (i / 4) % 3, i % 4), i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Npy_fortran_write_test) {
+  Elements::TempFile file(std::string("npy_testpy_fortran_write_%%.npy"));
+
+  NdArray<float> ndarray({3, 4});
+  std::iota(ndarray.begin(), ndarray.end(), 0.f);
+
+  // The transposition is column-major in memory
+  writeNpy(file.path(), ndarray.transpose());
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+a = np.load(sys.argv[1])
+assert a.flags.f_contiguous
+assert a.shape == (4, 3), a.shape
+assert (a == np.arange(12, dtype=np.float32).reshape(3, 4).T).all()
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  auto rend = readNpy<float>(file.path());
+  BOOST_CHECK(rend == ndarray.transpose());
+}
+
 BOOST_AUTO_TEST_CASE(AttrNames_test) {
   Elements::TempFile file(std::string("npy_testpy_attrs_%%.npy"));
 
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <ElementsKernel/Temporary.h>
+#include "NdArray/io/Npz.h"
+#include "TestHelper.h"
+
+using namespace Euclid::NdArray;
+
+BOOST_AUTO_TEST_SUITE(Npz_test)
+
+BOOST_AUTO_TEST_CASE(Npz_stored_test) {
+  Elements::TempFile file("npz_stored_%%.npz");
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+with open(sys.argv[1], 'wb') as fd:
+    np.savez(fd, a=np.arange(60, dtype=np.int32).reshape(3, 4, 5), b=np.linspace(0, 1, 7),
+             c=np.asfortranarray(np.arange(6, dtype=np.int64).reshape(2, 3)))
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  NpzReader npz(file.path(), boost::iostreams::mapped_file_base::priv);
+  std::vector<std::string> expected_names{"a", "b", "c"};
+  BOOST_CHECK(npz.names() == expected_names);
+  BOOST_CHECK(npz.contains("a"));
+  BOOST_CHECK(npz.contains("b.npy"));
+  BOOST_CHECK(!npz.contains("d"));
+
+  auto a = npz.get<int32_t>("a");
+  std::vector<size_t> expected_shape{3, 4, 5};
+  BOOST_CHECK(a.shape() == expected_shape);
+  for (size_t i = 0; i < 60; ++i) {
+    BOOST_CHECK_EQUAL(a.at(i / 20, (i / 5) % 4, i % 5), i);
+  }
+
+  auto b = npz.get<double>("b");
+  BOOST_CHECK_EQUAL(b.shape()[0], 7);
+  BOOST_CHECK_CLOSE(b.at(3), 0.5, 1e-8);
+
+  auto c = npz.get<int64_t>("c");
+  BOOST_CHECK_EQUAL(c.at(1, 2), 5);
+  BOOST_CHECK_EQUAL(c.at(0, 1), 1);
+
+  // The values can be converted, but then they are copied
+  auto b_float = npz.get<float>("b", NpyReadMode::CONVERT);
+  BOOST_CHECK_CLOSE(b_float.at(6), 1.f, 1e-5);
+  BOOST_CHECK_THROW(npz.get<float>("b"), Elements::Exception);
+  BOOST_CHECK_THROW(npz.get<float>("d"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(Npz_mapped_test) {
+  Elements::TempFile file("npz_mapped_%%.npz");
+
+  {
+    NpzWriter npz(file.path());
+    NdArray<float> ndarray({10, 10});
+    std::iota(ndarray.begin(), ndarray.end(), 0.f);
+    npz.add("x", ndarray);
+    npz.add("y", ndarray.transpose());
+  }
+
+  NpzReader npz(file.path(), boost::iostreams::mapped_file_base::priv);
+
+  // Both views share the mapping
+  auto x1 = npz.get<float>("x");
+  auto x2 = npz.get<float>("x");
+  x1.at(5, 5) = -1;
+  BOOST_CHECK_EQUAL(x2.at(5, 5), -1);
+
+  // Members of an archive can not grow
+  NdArray<float> row({1, 10});
+  BOOST_CHECK_THROW(x1.concatenate(row), Elements::Exception);
+
+  auto y = npz.get<float>("y");
+  BOOST_CHECK(!y.isContiguous());
+  BOOST_CHECK_EQUAL(y.at(2, 7), 72);
+}
+
+BOOST_AUTO_TEST_CASE(Npz_default_write_test) {
+  Elements::TempFile file("npz_default_%%.npz");
+
+  {
+    NpzWriter npz(file.path());
+    NdArray<float> ndarray({10, 10});
+    std::iota(ndarray.begin(), ndarray.end(), 0.f);
+    npz.add("x", ndarray);
+  }
+
+  // The default mode allows writing to the mapped members, without modifying the archive
+  {
+    NpzReader npz(file.path());
+    auto x = npz.get<float>("x");
+    x.at(1, 1) = 3;
+    BOOST_CHECK_EQUAL(x.at(1, 1), 3);
+  }
+  BOOST_CHECK_EQUAL(NpzReader(file.path()).get<float>("x").at(1, 1), 11);
+}
+
+BOOST_AUTO_TEST_CASE(Npz_compressed_test) {
+  Elements::TempFile file("npz_compressed_%%.npz");
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+with open(sys.argv[1], 'wb') as fd:
+    np.savez_compressed(fd, zeros=np.zeros((100, 100), dtype=np.float32),
+                        ramp=np.arange(1000, dtype='>i4'))
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  NpzReader npz(file.path());
+  auto zeros = npz.get<float>("zeros");
+  BOOST_CHECK_EQUAL(zeros.size(), 10000);
+  BOOST_CHECK(std::all_of(zeros.begin(), zeros.end(), [](float v) { return v == 0; }));
+
+  // Decompressed once
+  zeros.at(0, 0) = 1;
+  BOOST_CHECK_EQUAL(npz.get<float>("zeros").at(0, 0), 1);
+
+  BOOST_CHECK_THROW(npz.get<int32_t>("ramp"), Elements::Exception);
+  auto ramp = npz.get<int32_t>("ramp", NpyReadMode::CONVERT);
+  for (int32_t i = 0; i < 1000; ++i) {
+    BOOST_CHECK_EQUAL(ramp.at(i), i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Npz_compressed_mode_test) {
+  Elements::TempFile file("npz_compressed_mode_%%.npz");
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import numpy as np
+with open(sys.argv[1], 'wb') as fd:
+    np.savez_compressed(fd, ramp=np.arange(1000, dtype='>i4'))
+)EDOCYP";
+  runPython(PYCODE, file.path());
+
+  // A converted copy must not be returned by a later strict read
+  NpzReader npz(file.path());
+  auto ramp = npz.get<int32_t>("ramp", NpyReadMode::CONVERT);
+  BOOST_CHECK_EQUAL(ramp.at(999), 999);
+  BOOST_CHECK_THROW(npz.get<int32_t>("ramp"), Elements::Exception);
+  BOOST_CHECK_EQUAL(npz.get<int32_t>("ramp", NpyReadMode::CONVERT).at(10), 10);
+}
+
+BOOST_AUTO_TEST_CASE(Npz_write_test) {
+  Elements::TempFile stored_file("npz_write_%%.npz");
+  Elements::TempFile compressed_file("npz_write_compressed_%%.npz");
+
+  NdArray<int64_t> a({20, 30});
+  std::iota(a.begin(), a.end(), 0);
+  NdArray<double> b{{5}, std::vector<std::string>{"x", "y"}};
+  std::fill(b.begin(), b.end(), 3.5);
+
+  for (auto compress : {false, true}) {
+    auto path = compress ? compressed_file.path() : stored_file.path();
+    NpzWriter npz(path, compress);
+    npz.add("a", a);
+    npz.add("b", b);
+    BOOST_CHECK_THROW(npz.add("a", a), Elements::Exception);
+    npz.close();
+    BOOST_CHECK_THROW(npz.add("c", a), Elements::Exception);
+  }
+
+  constexpr const char *PYCODE = R"EDOCYP(
+import sys
+import zipfile
+import numpy as np
+with zipfile.ZipFile(sys.argv[1]) as archive:
+    assert archive.testzip() is None
+data = np.load(sys.argv[1])
+assert sorted(data.files) == ['a', 'b'], data.files
+assert (data['a'] == np.arange(600).reshape(20, 30)).all()
+assert data['b'].dtype.names == ('x', 'y')
+assert (data['b']['y'] == 3.5).all()
+)EDOCYP";
+  runPython(PYCODE, stored_file.path());
+  runPython(PYCODE, compressed_file.path());
+
+  for (auto path : {stored_file.path(), compressed_file.path()}) {
+    NpzReader npz(path);
+    BOOST_CHECK(npz.get<int64_t>("a") == a);
+    auto rb = npz.get<double>("b");
+    BOOST_CHECK(rb.attributes() == b.attributes());
+    BOOST_CHECK(rb == b);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Npz_notzip_test) {
+  Elements::TempFile file("npz_notzip_%%.npz");
+  writeNpy(file.path(), NdArray<int32_t>({100}));
+  BOOST_CHECK_THROW(NpzReader{file.path()}, Elements::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
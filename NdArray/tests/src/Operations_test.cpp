@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+* @file tests/src/Operations_test.cpp
+* @author Alejandro Alvarez Ayllon
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include "NdArray/NdArray.h"
+
+using namespace Euclid::NdArray;
+
+BOOST_AUTO_TEST_SUITE(Operations_test)
+
+BOOST_AUTO_TEST_CASE(Arithmetic_test) {
+  NdArray<int> a{2, 3}, b{2, 3};
+  std::iota(a.begin(), a.end(), 0);
+  std::iota(b.begin(), b.end(), 10);
+
+  NdArray<int> c = (a + b) * 2 - a / 2;
+
+  BOOST_CHECK_EQUAL(c.shape().size(), 2);
+  for (size_t i = 0; i < c.size(); ++i) {
+    int av = static_cast<int>(i), bv = static_cast<int>(i) + 10;
+    BOOST_CHECK_EQUAL(*(c.begin() + i), (av + bv) * 2 - av / 2);
+  }
+  BOOST_CHECK(NdArray<int>(-a) == NdArray<int>(a * -1));
+}
+
+BOOST_AUTO_TEST_CASE(ScalarType_test) {
+  NdArray<float> a{4};
+  std::fill(a.begin(), a.end(), 1.f);
+
+  // The scalar is converted to float
+  auto expr = a * 0.1;
+  static_assert(std::is_same<decltype(expr)::value_type, float>::value, "Expected a float expression");
+  NdArray<float> b = expr;
+  BOOST_CHECK_EQUAL(b.at(0), 1.f * 0.1f);
+}
+
+BOOST_AUTO_TEST_CASE(MixedScalarType_test) {
+  NdArray<int> a{4};
+  std::iota(a.begin(), a.end(), 1);
+
+  // A floating point scalar promotes the integral array, instead of being truncated
+  auto expr = a * 2.5;
+  static_assert(std::is_same<decltype(expr)::value_type, double>::value, "Expected a double expression");
+  NdArray<double> b = expr + 0.9;
+  for (size_t i = 0; i < 4; ++i) {
+    BOOST_CHECK_CLOSE(b.at(i), (i + 1) * 2.5 + 0.9, 1e-8);
+  }
+
+  NdArray<uint8_t> mask = a < 2.5;
+  std::vector<uint8_t> expected_mask{1, 1, 0, 0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(mask.begin(), mask.end(), expected_mask.begin(), expected_mask.end());
+
+  NdArray<double> half = where(a > 2, a, 0.5);
+  BOOST_CHECK_EQUAL(half.at(0), 0.5);
+  BOOST_CHECK_EQUAL(half.at(3), 4.);
+
+  // Integral scalars keep the type of the array
+  static_assert(std::is_same<decltype(a * 2L)::value_type, int>::value, "Expected an int expression");
+}
+
+BOOST_AUTO_TEST_CASE(Broadcast_test) {
+  NdArray<int> matrix{3, 4}, row{4}, column{3, 1};
+  std::iota(matrix.begin(), matrix.end(), 0);
+  std::iota(row.begin(), row.end(), 100);
+  std::iota(column.begin(), column.end(), 1000);
+
+  NdArray<int> result = matrix + row + column;
+
+  BOOST_CHECK_EQUAL(result.shape()[0], 3);
+  BOOST_CHECK_EQUAL(result.shape()[1], 4);
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      BOOST_CHECK_EQUAL(result.at(i, j), matrix.at(i, j) + row.at(j) + column.at(i, 0));
+    }
+  }
+
+  NdArray<int> outer = row * column;
+  BOOST_CHECK_EQUAL(outer.shape()[0], 3);
+  BOOST_CHECK_EQUAL(outer.shape()[1], 4);
+  BOOST_CHECK_EQUAL(outer.at(2, 3), 103 * 1002);
+
+  NdArray<int> bad{3};
+  BOOST_CHECK_THROW(matrix + bad, std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(Views_test) {
+  NdArray<double> m{4, 4};
+  std::iota(m.begin(), m.end(), 0);
+
+  NdArray<double> result = m.transpose() - m;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      BOOST_CHECK_EQUAL(result.at(i, j), m.at(j, i) - m.at(i, j));
+    }
+  }
+
+  // Write into a strided view
+  auto diagonal_block = m.slice({Slice(0, 4, 2), Slice(0, 4, 2)});
+  diagonal_block *= 10;
+  BOOST_CHECK_EQUAL(m.at(2, 2), 100);
+  BOOST_CHECK_EQUAL(m.at(2, 3), 11);
+}
+
+BOOST_AUTO_TEST_CASE(Functions_test) {
+  NdArray<double> a{5};
+  std::iota(a.begin(), a.end(), 1);
+
+  NdArray<double> result = sqrt(pow(a, 2.)) + abs(-a) + exp(log(a)) + log10(a * 0 + 10);
+
+  for (size_t i = 0; i < 5; ++i) {
+    BOOST_CHECK_CLOSE(result.at(i), 3 * a.at(i) + 1, 1e-8);
+  }
+  NdArray<double> trig = sin(a) * sin(a) + cos(a) * cos(a) - tan(a * 0);
+  for (auto v : trig) {
+    BOOST_CHECK_CLOSE(v, 1., 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Comparison_test) {
+  NdArray<int> a{6};
+  std::iota(a.begin(), a.end(), 0);
+
+  // The sum of booleans is a logical or, as in numpy
+  NdArray<uint8_t> mask = (a < 2) + (a > 4);
+  std::vector<uint8_t> expected_mask{1, 1, 0, 0, 0, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(mask.begin(), mask.end(), expected_mask.begin(), expected_mask.end());
+
+  NdArray<int> clipped = where(a > 3, 3, where(a <= 1, 1, a));
+  std::vector<int> expected_clip{1, 1, 2, 3, 3, 3};
+  BOOST_CHECK_EQUAL_COLLECTIONS(clipped.begin(), clipped.end(), expected_clip.begin(), expected_clip.end());
+
+  NdArray<int> eq = where(equal(a, 2), 10, 0) + NdArray<int>(notEqual(a, 5));
+  std::vector<int> expected_eq{1, 1, 11, 1, 1, 0};
+  BOOST_CHECK_EQUAL_COLLECTIONS(eq.begin(), eq.end(), expected_eq.begin(), expected_eq.end());
+}
+
+BOOST_AUTO_TEST_CASE(CompoundAssignment_test) {
+  NdArray<float> a{2, 3};
+  NdArray<float> row{3};
+  std::iota(a.begin(), a.end(), 0);
+  std::iota(row.begin(), row.end(), 1);
+
+  a += row;
+  a -= 1;
+  a /= row * 2;
+
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      BOOST_CHECK_CLOSE(a.at(i, j), (i * 3 + j + j) / (2. * (j + 1)), 1e-5);
+    }
+  }
+  // The shape of the destination can not change
+  NdArray<float> column{2, 1};
+  BOOST_CHECK_THROW(row += column, std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(Overlap_test) {
+  NdArray<int> a{3, 3};
+  std::iota(a.begin(), a.end(), 0);
+
+  // Same memory, transposed
+  a += a.transpose();
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      BOOST_CHECK_EQUAL(a.at(i, j), (i * 3 + j) + (j * 3 + i));
+    }
+  }
+
+  // Overlapping, shifted, slices
+  NdArray<int> b{10};
+  std::iota(b.begin(), b.end(), 0);
+  auto tail = b.slice(0, Slice(1));
+  tail *= b.slice(0, Slice(0, 9)) + 1;
+  std::vector<int> expected{0, 1, 4, 9, 16, 25, 36, 49, 64, 81};
+  BOOST_CHECK_EQUAL_COLLECTIONS(b.begin(), b.end(), expected.begin(), expected.end());
+
+  // Broadcast of a part of the destination
+  NdArray<int> c{3, 2};
+  std::iota(c.begin(), c.end(), 1);
+  c -= c.slice(0, Slice(0, 1));
+  std::vector<int> expected_c{0, 0, 2, 2, 4, 4};
+  BOOST_CHECK_EQUAL_COLLECTIONS(c.begin(), c.end(), expected_c.begin(), expected_c.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
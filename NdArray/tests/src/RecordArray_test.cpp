@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <numeric>
+#include <boost/test/unit_test.hpp>
+#include "NdArray/RecordArray.h"
+
+using namespace Euclid::NdArray;
+
+BOOST_AUTO_TEST_SUITE(RecordArray_test)
+
+BOOST_AUTO_TEST_CASE(Fields_test) {
+  RecordArray records({4, 5});
+  BOOST_CHECK_EQUAL(records.size(), 20);
+
+  NdArray<int64_t> id({4, 5});
+  std::iota(id.begin(), id.end(), 0);
+  records.addField("ID", id);
+  records.addField("FLUX", NdArray<float>({4, 5}));
+
+  std::vector<std::string> expected{"ID", "FLUX"};
+  BOOST_CHECK(records.fields() == expected);
+  BOOST_CHECK(records.hasField("FLUX"));
+  BOOST_CHECK(!records.hasField("flux"));
+  BOOST_CHECK(records.fieldType("ID") == typeid(int64_t));
+  BOOST_CHECK(records.fieldType("FLUX") == typeid(float));
+  BOOST_CHECK(records.field<int64_t>("ID") == id);
+}
+
+BOOST_AUTO_TEST_CASE(Shared_test) {
+  RecordArray records({10});
+  NdArray<double> flux({10});
+  records.addField("FLUX", flux);
+
+  // Neither addField nor field copy the values
+  flux.at(3) = 42.;
+  BOOST_CHECK_EQUAL(records.field<double>("FLUX").at(3), 42.);
+  records.field<double>("FLUX").at(5) = 24.;
+  BOOST_CHECK_EQUAL(flux.at(5), 24.);
+}
+
+BOOST_AUTO_TEST_CASE(View_test) {
+  NdArray<int32_t> table{{10}, std::vector<std::string>{"x", "y"}};
+  std::iota(table.begin(), table.end(), 0);
+
+  RecordArray records({10});
+  records.addField("y", table.field("y"));
+  BOOST_CHECK_EQUAL(records.field<int32_t>("y").at(4), 9);
+}
+
+BOOST_AUTO_TEST_CASE(Errors_test) {
+  RecordArray records({10});
+  records.addField("a", NdArray<int16_t>({10}));
+
+  BOOST_CHECK_THROW(records.addField("a", NdArray<int16_t>({10})), std::invalid_argument);
+  BOOST_CHECK_THROW(records.addField("b", NdArray<int16_t>({5})), std::invalid_argument);
+  BOOST_CHECK_THROW(records.addField("b", NdArray<int16_t>({10, 1})), std::invalid_argument);
+  BOOST_CHECK_THROW(records.field<int32_t>("a"), std::invalid_argument);
+  BOOST_CHECK_THROW(records.field<int16_t>("c"), std::out_of_range);
+  BOOST_CHECK_THROW(records.fieldType("c"), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2012-2020 Euclid Science Ground Segment
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation; either version 3.0 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+* @file tests/src/Reductions_test.cpp
+* @author Alejandro Alvarez Ayllon
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <random>
+#include "NdArray/Reductions.h"
+
+using namespace Euclid::NdArray;
+using Euclid::ThreadPool;
+
+namespace {
+
+/// Naive reduction along an axis, visiting the elements with at()
+template<typename T, typename R, typename F>
+std::vector<R> naiveAxis(const NdArray<T>& array, size_t axis, R init, F fn) {
+  auto shape = array.shape();
+  size_t n = shape[axis];
+  shape.erase(shape.begin() + axis);
+  size_t out_size = std::accumulate(shape.begin(), shape.end(), size_t{1}, std::multiplies<size_t>());
+
+  std::vector<R> result;
+  std::vector<size_t> coords(shape.size());
+  for (size_t j = 0; j < out_size; ++j) {
+    size_t pos = j;
+    for (size_t i = shape.size(); i > 0; --i) {
+      coords[i - 1] = pos % shape[i - 1];
+      pos /= shape[i - 1];
+    }
+    std::vector<size_t> full{coords};
+    full.insert(full.begin() + axis, 0);
+    R acc = init;
+    for (size_t k = 0; k < n; ++k) {
+      full[axis] = k;
+      acc = fn(acc, array.at(full), k);
+    }
+    result.emplace_back(acc);
+  }
+  return result;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(Reductions_test)
+
+BOOST_AUTO_TEST_CASE(WholeArray_test) {
+  NdArray<int> array{3, 4};
+  std::vector<int> values{5, -2, 7, 1, 9, 0, 9, -3, 4, 4, 6, -3};
+  std::copy(values.begin(), values.end(), array.begin());
+
+  BOOST_CHECK_EQUAL(sum(array), 37);
+  BOOST_CHECK_CLOSE(mean(array), 37. / 12., 1e-8);
+  BOOST_CHECK_EQUAL(min(array), -3);
+  BOOST_CHECK_EQUAL(max(array), 9);
+  // First occurrences
+  BOOST_CHECK_EQUAL(argmin(array), 7);
+  BOOST_CHECK_EQUAL(argmax(array), 4);
+}
+
+BOOST_AUTO_TEST_CASE(Axis_test) {
+  NdArray<int> array{4, 5, 6};
+  std::mt19937 gen{42};
+  std::uniform_int_distribution<int> dist{-20, 20};
+  std::generate(array.begin(), array.end(), [&]() { return dist(gen); });
+
+  for (size_t axis = 0; axis < 3; ++axis) {
+    auto sums = sum(array, axis);
+    auto expected = naiveAxis(array, axis, 0, [](int acc, int v, size_t) { return acc + v; });
+    BOOST_CHECK_EQUAL_COLLECTIONS(sums.begin(), sums.end(), expected.begin(), expected.end());
+
+    auto maxs = max(array, axis);
+    auto expected_max = naiveAxis(array, axis, -100, [](int acc, int v, size_t) { return std::max(acc, v); });
+    BOOST_CHECK_EQUAL_COLLECTIONS(maxs.begin(), maxs.end(), expected_max.begin(), expected_max.end());
+
+    auto argmaxs = argmax(array, axis);
+    auto expected_arg = naiveAxis(array, axis, std::make_pair(-100, size_t{0}),
+                                  [](std::pair<int, size_t> acc, int v, size_t k) {
+                                    return v > acc.first ? std::make_pair(v, k) : acc;
+                                  });
+    BOOST_CHECK_EQUAL(argmaxs.size(), expected_arg.size());
+    for (size_t j = 0; j < expected_arg.size(); ++j) {
+      BOOST_CHECK_EQUAL(*(argmaxs.begin() + j), expected_arg[j].second);
+    }
+  }
+
+  auto means = mean(array, 2);
+  std::vector<size_t> expected_shape{4, 5};
+  BOOST_CHECK(means.shape() == expected_shape);
+  BOOST_CHECK_CLOSE(means.at(1, 2), sum(array, 2).at(1, 2) / 6., 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(StridedView_test) {
+  NdArray<double> array{10, 12};
+  std::iota(array.begin(), array.end(), 0.);
+
+  // Every other row and every third column, transposed
+  auto view = array.slice({Slice(0, Slice::END, 2), Slice(1, Slice::END, 3)}).transpose();
+  NdArray<double> copy = view.copy();
+
+  BOOST_CHECK_EQUAL(sum(view), sum(copy));
+  BOOST_CHECK_EQUAL(argmin(view), argmin(copy));
+  for (size_t axis = 0; axis < 2; ++axis) {
+    BOOST_CHECK(sum(view, axis) == sum(copy, axis));
+    BOOST_CHECK(min(view, axis) == min(copy, axis));
+    BOOST_CHECK(argmax(view, axis) == argmax(copy, axis));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PairwiseSum_test) {
+  // A naive float sum of 0.1 stalls far from the exact value
+  NdArray<float> array{1 << 22};
+  std::fill(array.begin(), array.end(), 0.1f);
+
+  double exact = 0.1f * static_cast<double>(array.size());
+  BOOST_CHECK_CLOSE(sum(array), exact, 1e-3);
+  BOOST_CHECK_CLOSE(mean(array), 0.1f, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(Norm_test) {
+  NdArray<int> array{2, 2};
+  std::vector<int> values{3, -4, 0, 1};
+  std::copy(values.begin(), values.end(), array.begin());
+
+  BOOST_CHECK_CLOSE(norm(array), std::sqrt(26.), 1e-8);
+  BOOST_CHECK_CLOSE(norm(array, 1.), 8., 1e-8);
+  BOOST_CHECK_CLOSE(norm(array, std::numeric_limits<double>::infinity()), 4., 1e-8);
+  BOOST_CHECK_CLOSE(norm(array, 3.), std::cbrt(27. + 64. + 1.), 1e-8);
+
+  auto rows = norm(array, 1, 2.);
+  BOOST_CHECK_CLOSE(rows.at(0), 5., 1e-8);
+  BOOST_CHECK_CLOSE(rows.at(1), 1., 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(Parallel_test) {
+  ThreadPool pool{4};
+  NdArray<int64_t> array{300, 500};
+  std::iota(array.begin(), array.end(), 0);
+
+  int64_t n = array.size();
+  BOOST_CHECK_EQUAL(sum(array, pool), n * (n - 1) / 2);
+  BOOST_CHECK_EQUAL(argmax(array, pool), array.size() - 1);
+
+  // Same result as a single thread, for both kernels
+  ThreadPool single{1};
+  BOOST_CHECK(sum(array, 0, pool) == sum(array, 0, single));
+  BOOST_CHECK(sum(array, 1, pool) == sum(array, 1, single));
+  BOOST_CHECK(max(array.transpose(), 1, pool) == max(array, 0, single));
+}
+
+BOOST_AUTO_TEST_CASE(Empty_test) {
+  NdArray<float> array{0, 3};
+
+  BOOST_CHECK_EQUAL(sum(array), 0);
+  BOOST_CHECK(std::isnan(mean(array)));
+  BOOST_CHECK_THROW(min(array), std::invalid_argument);
+  BOOST_CHECK_THROW(argmax(array), std::invalid_argument);
+  BOOST_CHECK_THROW(max(array, 0), std::invalid_argument);
+  BOOST_CHECK_EQUAL(sum(array, 1).size(), 0);
+  BOOST_CHECK_THROW(sum(array, 2), std::out_of_range);
+  BOOST_CHECK_THROW(norm(array, 0.), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()